@@ -26,6 +26,7 @@
 #include <cstdint>
 #include <cassert>
 #include <string>
+#include <vector>
 #include "./tag_value.h"
 
 namespace osm2pgr {
@@ -51,8 +52,8 @@ class Tag_key : Element {
     inline int64_t id() const {return osm_id();}
     inline std::string name() const {return get_attribute("name");}
 
-    /* used in the export function */
-    std::vector<std::string> values(
+    /* used in the export function: a row per tag value */
+    std::vector<std::vector<std::string>> values(
             const std::vector<std::string> &columns) const;
 
  private:
@@ -25,15 +25,19 @@
 #include <pqxx/pqxx>
 #include <libpq-fe.h>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 
 #include "osm_elements/Node.h"
 #include "osm_elements/Way.h"
+#include "osm_elements/node_store.h"
+#include "osm_elements/topology.h"
 #include "osm_elements/Relation.h"
 #include "configuration/configuration.h"
 #include "utilities/prog_options.h"
 #include "database/table_management.h"
+#include "database/copy_writer.h"
 
 namespace osm2pgr {
 
@@ -81,57 +85,135 @@ class Export2DB {
       * T must have:
       *     T.values
       *
-      * @param[in] items  vector of values to be inserted into
+      * @param[in] begin, end  items to be inserted into
       * @param[in] table 
       */
-     template <typename T>
+     template <typename Iterator>
          void export_osm (
-                 std::vector<T> &items,
+                 Iterator begin,
+                 Iterator end,
                  const std::string &table) const {
              auto osm_table = m_tables.get_table(table);
-             std::vector<std::string> values(items.size(), "");
+             const auto &columns = osm_table.columns();
+             Copy_writer rows;
 
-             size_t i(0);
-             for (auto it = items.begin(); it != items.end(); ++it, ++i) {
-                 auto item = *it;
-                 values[i] = tab_separated(item.values(osm_table.columns(), true));
+             for (auto it = begin; it != end; ++it) {
+                 rows.fields(it->values(columns, true));
+                 rows.end_row();
              }
 
-             export_osm(values, osm_table);
+             export_osm(rows.rows(), osm_table);
          }
 
+     /** @brief export ways to the osm_ways table
+      *
+      * @param[in] begin, end  ways to be inserted
+      * @param[in] nodes  nodes of the ways geometries
+      * @param[in] table
+      */
+     void export_osm(
+             Ways::const_iterator begin,
+             Ways::const_iterator end,
+             const Node_store &nodes,
+             const std::string &table) const;
+
      void export_configuration(
              const std::map<std::string, Tag_key>& items) const;
 
      void exportWays(
              const Ways &ways,
+             const Node_store &nodes,
              const Configuration &config) const;
 
      void dropTables() const;
      void createFKeys() const;
      void process_pois() const;
+     //! tables SET LOGGED, autovacuum & ANALYZE after the import
+     void finish_load() const;
      bool exists(const std::string &table) const;
 
  private:
 
+     /** @brief COPY rows to the table
+      *
+      * When the server rejects the rows, they are copied again in halves
+      * to find the rejected row.
+      *
+      * @param[in] rows  rows written by a Copy_writer
+      * @param[in] table
+      */
      void export_osm(
-             const std::vector<std::string> &values,
+             const std::string &rows,
              const Table &table) const;
 
-     void process_section(const std::string &ways_columns, pqxx::work &Xaction) const;
-
-     void fill_vertices_table(
-             const std::string &table,
-             const std::string &vertices_tab,
+     /** @brief moves the rows of a ways temporary table to the ways table
+      *
+      * @param[in] temp_table  the temporary table
+      * @param[in] ways_columns  the copied columns
+      * @param[in] existing_ways  remove the ways that are already in the ways table
+      * @param[in] Xaction
+      */
+     void process_section(
+             const std::string &temp_table,
+             const std::string &ways_columns,
+             bool existing_ways,
              pqxx::work &Xaction) const;
 
-     void fill_source_target(
+     /** @brief ways exported on several connections
+      *
+      * Each connection COPYs its chunks into its own staging table,
+      * the staging tables are merged once all the rows are copied.
+      */
+     void export_ways_concurrently(
+             const Ways &ways,
+             const Node_store &nodes,
+             const Configuration &config,
+             const Topology &topology,
+             bool existing_ways,
+             size_t connections) const;
+
+     /** @brief numbers the vertices of the ways & copies the new ones
+      *
+      * @param[in] ways
+      * @param[in] nodes  nodes of the ways
+      * @param[in] existing_ways  the ways table has rows
+      * @param[out] topology  the ids of the vertices
+      */
+     void export_vertices(
+             const Ways &ways,
+             const Node_store &nodes,
+             bool existing_ways,
+             Topology &topology) const;
+
+     /** @brief starts a COPY on @b conn in a transaction
+      *
+      * @param[in] conn
+      * @param[in] prepare  statement creating or truncating the table (can be empty)
+      * @param[in] table  the table copied
+      * @param[in] columns  the copied columns
+      * @param[in] binary  binary format
+      */
+     void begin_copy(
+             PGconn *conn,
+             const std::string &prepare,
              const std::string &table,
-             const std::string &vertices_tab,
-             pqxx::work &Xaction) const;
+             const std::string &columns,
+             bool binary) const;
+     //! ends the COPY & its transaction, false when the rows were rejected
+     bool end_copy(PGconn *conn) const;
+
+     //! session of the statements, opened on first use
+     pqxx::connection& connection() const;
+     //! session of the COPYs, opened on first use
+     PGconn* copy_connection() const;
 
      int64_t get_val(const std::string sql) const;
      void execute(const std::string sql) const;
+     /** @brief runs the jobs on --index-connections sessions
+      *
+      * @param[in] jobs  each job is a list of statements run in order in one session
+      */
+     void execute_concurrently(const std::vector<std::vector<std::string>> &jobs) const;
 
      Table configuration() const {return m_tables.configuration();}
      Table vertices() const {return m_tables.vertices();}
@@ -148,6 +230,9 @@ class Export2DB {
 
      Tables m_tables;
 
+     mutable std::unique_ptr<pqxx::connection> m_connection;
+     mutable PGconn *m_copy_connection;
+
 };
 }  // namespace osm2pgr
 
@@ -0,0 +1,103 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/** @file **/
+
+#ifndef SRC_BINARY_COPY_WRITER_H_
+#define SRC_BINARY_COPY_WRITER_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace osm2pgr {
+
+/** @brief rows of a COPY ... FROM STDIN WITH (FORMAT binary)
+
+  Same interface as Copy_writer, the fields are written in binary:
+  - integers and doubles in network byte order
+  - the linestrings in EWKB (srid 4326), so the server
+    does not parse the coordinates
+  - an empty string is NULL
+
+  The field types must be the types of the columns:
+  int32_t for integer, int64_t for bigint, double for double precision.
+
+  The rows of several writers can be concatenated,
+  the data sent starts with header() and ends with trailer().
+  */
+class Binary_copy_writer {
+ public:
+     //! @param fields  number of fields of a row
+     explicit Binary_copy_writer(size_t fields) :
+         m_fields(static_cast<int16_t>(fields)),
+         m_row_start(true) {}
+
+     void field(const std::string &value) {field(value.data(), value.size());}
+     void field(const char *value, size_t size);
+     void field(int32_t value);
+     void field(int64_t value);
+     void field(double value);
+
+     //! coordinate in units of 1e-7 degrees
+     void coordinate(int32_t value);
+
+     //! linestring field of @b points points (EWKB)
+     void linestring(size_t points);
+     void point(int32_t lon, int32_t lat);
+     void end_linestring() {}
+
+     inline void end_row() {m_row_start = true;}
+
+     inline const std::string& rows() const {return m_rows;}
+     inline bool empty() const {return m_rows.empty();}
+
+     //! moves the rows out of the writer
+     inline std::string take() {
+         std::string rows;
+         rows.swap(m_rows);
+         m_row_start = true;
+         return rows;
+     }
+
+     //! the capacity is kept: the buffer is reused
+     inline void clear() {
+         m_rows.clear();
+         m_row_start = true;
+     }
+
+     //! signature, flags & header extension
+     static std::string header();
+     //! end of the data
+     static std::string trailer();
+
+ private:
+     //! the field count starts a row
+     void start_field();
+
+ private:
+     std::string m_rows;
+     int16_t m_fields;
+     bool m_row_start;
+};
+
+}  // end namespace osm2pgr
+#endif  // SRC_BINARY_COPY_WRITER_H_
@@ -0,0 +1,161 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/** @file **/
+
+#ifndef SRC_COPY_WRITER_H_
+#define SRC_COPY_WRITER_H_
+#pragma once
+
+#include <libpq-fe.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osm2pgr {
+
+/** @brief rows of a COPY ... FROM STDIN (text format)
+
+  The fields are written directly in a buffer that is reused:
+  - tab separated, one row per line
+  - \N for an empty field (NULL)
+  - backslash, tab, newline & carriage return are escaped
+
+  The rows are sent with PQputCopyData in blocks of 1 MB.
+
+  @code
+  Copy_writer writer;
+  for (...) {
+      writer.field(osm_id);
+      writer.field(name);
+      writer.end_row();
+  }
+  Copy_writer::put(conn, writer.rows());
+  Copy_writer::end(conn);
+  @endcode
+  */
+class Copy_writer {
+ public:
+     Copy_writer() : m_row_start(true), m_points(0) {}
+
+     //! appends a field to the current row
+     void field(const std::string &value) {field(value.data(), value.size());}
+     void field(const char *value, size_t size);
+
+     void field(int32_t value);
+     void field(int64_t value);
+     void field(double value);
+
+     //! appends the fields to the current row
+     void fields(const std::vector<std::string> &values) {
+         for (const auto &value : values) field(value);
+     }
+
+     //! coordinate in units of 1e-7 degrees
+     void coordinate(int32_t value);
+
+     /** @brief linestring field of @b points points (EWKT)
+      *
+      * @code
+      * writer.linestring(2);
+      * writer.point(lon1, lat1);
+      * writer.point(lon2, lat2);
+      * writer.end_linestring();
+      * @endcode
+      * the coordinates are in units of 1e-7 degrees
+      */
+     void linestring(size_t points);
+     void point(int32_t lon, int32_t lat);
+     void end_linestring();
+
+     //! point field (EWKT), the coordinates are in units of 1e-7 degrees
+     void point_geometry(int32_t lon, int32_t lat);
+
+     //! ends the current row
+     inline void end_row() {
+         m_rows += '\n';
+         m_row_start = true;
+     }
+
+     inline const std::string& rows() const {return m_rows;}
+     inline bool empty() const {return m_rows.empty();}
+
+     //! moves the rows out of the writer
+     inline std::string take() {
+         std::string rows;
+         rows.swap(m_rows);
+         m_row_start = true;
+         return rows;
+     }
+
+     //! the capacity is kept: the buffer is reused
+     inline void clear() {
+         m_rows.clear();
+         m_row_start = true;
+     }
+
+     /**
+      * starts a transaction on @b conn, runs @b prepare and starts
+      * the COPY @b copy_sql
+      *
+      * @b prepare can be empty, it can hold several statements
+      * (CREATE TABLE ...; SELECT AddGeometryColumn(...);)
+      *
+      * @throws std::runtime_error when a statement fails,
+      * the transaction is rolled back: the session can be used again
+      */
+     static void begin(
+             PGconn *conn,
+             const std::string &prepare,
+             const std::string &copy_sql);
+
+     /**
+      * sends @b size bytes of rows to the COPY in progress on @b conn
+      *
+      * @returns false when the connection failed
+      */
+     static bool put(PGconn *conn, const char *rows, size_t size);
+     static bool put(PGconn *conn, const std::string &rows) {
+         return put(conn, rows.data(), rows.size());
+     }
+
+     /**
+      * ends the COPY in progress on @b conn
+      *
+      * @returns false when the server rejected the rows
+      */
+     static bool end(PGconn *conn);
+
+ private:
+     void separator() {
+         if (!m_row_start) m_rows += '\t';
+         m_row_start = false;
+     }
+
+ private:
+     std::string m_rows;
+     bool m_row_start;
+     //! points written in the current linestring
+     size_t m_points;
+};
+
+}  // end namespace osm2pgr
+#endif  // SRC_COPY_WRITER_H_
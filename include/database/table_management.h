@@ -60,7 +60,11 @@ class Table {
 
      /** sql queries
       */
-     std::string primary_key(const std::string &column) const;
+     //! unique index of the primary key (or of the unique constraint) on @b column
+     std::string key_index(const std::string &column, bool primary) const;
+     //! primary key on the index built by key_index
+     std::string primary_key() const;
+     //! unique constraint on the index built by key_index
      std::string unique(const std::string &column) const;
      std::string foreign_key(
              const std::string &column,
@@ -68,14 +72,16 @@ class Table {
              const std::string &table_column) const;
      std::string gist_index() const;
 
-     inline std::vector<std::string> columns() const {
+     inline const std::vector<std::string>& columns() const {
          return m_columns;
      }
      std::string sql(int i) const {return m_sql[i];}
 
 
      std::string tmp_create() const;
-     std::string create() const;
+     //! unlogged table @b name with the columns of the table
+     std::string tmp_create(const std::string &name) const;
+     std::string create(bool unlogged = false) const;
      std::string drop() const;
 
      /* modifier */
@@ -28,6 +28,7 @@
 #include <string>
 #include <map>
 #include "./osm_element.h"
+#include "utilities/number_format.h"
 
 namespace osm2pgr {
 
@@ -84,15 +85,26 @@ class Node : public Element {
      }
 
      inline std::string osm_id_str() {
-         return boost::lexical_cast<std::string>(m_osm_id);
+         return number_str(m_osm_id);
      }
-     double getLength(const Node &previous) const;
 
 
      inline uint16_t incrementUse() {return ++m_numsOfUse;}
      inline uint16_t numsOfUse() const {return m_numsOfUse;}
      inline void numsOfUse(uint16_t val)  {m_numsOfUse = val;}
 
+     /**
+      * coordinate in units of 1e-7 degrees (the OSM precision)
+      *   "45.1234567" -> 451234567
+      */
+     static int32_t fixed_point(const std::string &coordinate);
+
+     /**
+      * coordinate written with 7 decimals
+      *   451234567 -> "45.1234567"
+      */
+     static std::string coordinate_str(int32_t coordinate);
+
  private:
      /**
       *    counts the rate, how much this node is used in different ways
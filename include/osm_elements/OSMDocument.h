@@ -26,9 +26,11 @@
 #include <map>
 #include <vector>
 #include "utilities/utilities.h"
+#include "utilities/id_bitmap.h"
 #include "configuration/configuration.h"
 #include "utilities/prog_options.h"
 #include "database/Export2DB.h"
+#include "osm_elements/node_store.h"
 
 namespace osm2pgr {
 
@@ -50,10 +52,7 @@ class OSMDocument {
     OSMDocument(
             const Configuration& config,
             const po::variables_map &vm,
-            const Export2DB &db_conn,
-            size_t lines);
-
-    inline size_t lines() const {return m_lines;}
+            const Export2DB &db_conn);
 
     //! Do the configuration has the @b tag ?
     inline bool config_has_tag(const Tag &tag) const {
@@ -68,24 +67,63 @@ class OSMDocument {
         return m_rConfig.maxspeed(tag);
     }
 
-    const Nodes& nodes() const {return m_nodes;}
+    const Node_store& nodes() const {return m_nodes;}
     const Ways& ways() const {return m_ways;}
     const Relations& relations() const {return m_relations;}
 
+    /**
+     * only the @b nodes are kept by AddNode
+     * and only the @b ways are kept by AddWay
+     * (the routable ways and their nodes found by a first pass)
+     */
+    void keep_only(Id_bitmap &&nodes, Id_bitmap &&ways);
+
+    /**
+     * the nodes are kept in the memory mapped files @b file.*
+     *
+     * @returns false when the files can not be created
+     */
+    inline bool map_nodes(const std::string &file) {return m_nodes.map(file);}
+
+    //! Is the node kept?
+    inline bool keeps(int64_t node_id) const {
+        return !m_keep_only || m_kept_nodes.test(node_id);
+    }
+
     void AddNode(const Node &n);
     void AddWay(const Way &w);
     void AddRelation(const Relation &r);
+    //! the nodes section is over: the ways can be added
+    void endOfNodes();
     void endOfFile();
 
     //! find node by using an ID
     bool has_node(int64_t nodeRefId) const;
-    Node* FindNode(int64_t nodeRefId);
 
     bool has_way(int64_t way_id) const;
     Way* FindWay(int64_t way_id);
 
 
-    void add_node(Way &way, const char **atts);
+    /**
+     * adds the @b nd reference to the way,
+     * the node is found with the other nodes of the way by find_nodes
+     */
+    void add_node(Way &way, const char **atts) const;
+
+    /**
+     * finds the nodes of a way without counting their uses:
+     * the document is not modified, so the ways can be parsed concurrently
+     */
+    void find_nodes(Way &way) const;
+
+    //! finds the nodes of the ways with a single pass over the nodes
+    void find_nodes(Ways::iterator begin, Ways::iterator end) const;
+
+    /**
+     * counts the uses of the nodes of a way found with find_nodes
+     * and the references to missing nodes
+     */
+    void use_nodes(Way &way);
 
     /**
      * add the configuration tag used for the speeds
@@ -121,9 +159,8 @@ class OSMDocument {
             }
             auto residue = osm_items.size() % m_chunk_size;
             size_t start = residue? osm_items.size() - residue : osm_items.size() - m_chunk_size;
-            auto export_items = T(osm_items.begin() + start, osm_items.end());
 
-            m_db_conn.export_osm(export_items, table);
+            export_chunk(osm_items.begin() + start, osm_items.end(), table);
 
             if (m_vm.count("addnodes")) {
 #if 0
@@ -135,12 +172,28 @@ class OSMDocument {
             }
         }
 
+    template <typename Iterator>
+        void
+        export_chunk(Iterator begin, Iterator end, const std::string &table) const {
+            m_db_conn.export_osm(begin, end, table);
+        }
+
+    //! the geometry of the ways comes from the nodes
+    void export_chunk(
+            Ways::const_iterator begin,
+            Ways::const_iterator end,
+            const std::string &table) const {
+        m_db_conn.export_osm(begin, end, m_nodes, table);
+    }
+
    void export_pois() const;
 
 
  private:
-    // ! parsed nodes TODO change to sorted vector
-    Nodes m_nodes;
+    //! parsed nodes, sorted by id
+    Node_store m_nodes;
+    //! nodes waiting to be exported to osm_nodes (--addnodes)
+    Nodes m_osm_nodes;
     //! parsed ways
     Ways m_ways;
     //! parsed relations
@@ -154,7 +207,10 @@ class OSMDocument {
 
     size_t m_chunk_size;
     uint16_t m_nodeErrs;
-    size_t m_lines;
+
+    bool m_keep_only;
+    Id_bitmap m_kept_nodes;
+    Id_bitmap m_kept_ways;
 };
 
 }  // end namespace osm2pgr
@@ -27,6 +27,8 @@
 #include <string>
 #include "./osm_element.h"
 #include "./Node.h"
+#include "./node_store.h"
+#include "utilities/number_format.h"
 
 namespace osm2pgr {
 
@@ -61,11 +63,19 @@ class Way : public Element {
       */
      explicit Way(const char **atts);
      Tag add_tag(const Tag &tag);
-     void add_node(Node* node);
+     //! @param index  position of the node in the Node_store
+     void add_node_index(size_t index);
      void add_node(int64_t node_id);
 
-     std::vector<Node*>& nodeRefs() {return m_NodeRefs;}
-     const std::vector<Node*> nodeRefs() const {return m_NodeRefs;}
+     //! positions in the Node_store of the nodes of the way
+     const std::vector<size_t>& nodeRefs() const {return m_NodeRefs;}
+     const std::vector<int64_t>& node_ids() const {return m_node_ids;}
+
+     /**
+      * the node ids are not needed once the nodes are found
+      * (members_str needs them for the osm_ways table)
+      */
+     inline void drop_node_ids() {std::vector<int64_t>().swap(m_node_ids);}
 
 
      std::string members_str() const;
@@ -78,6 +88,7 @@ class Way : public Element {
 
 
      std::string oneWay() const;
+     int oneWayType() const;
      std::string oneWayType_str() const;
      inline bool is_oneway() const { return m_oneWay == "YES";}
      inline bool is_reversed() const { return m_oneWay == "REVERSED";}
@@ -85,22 +96,43 @@ class Way : public Element {
      inline double maxspeed_forward() const {return m_maxspeed_forward;}
      inline double maxspeed_backward() const { return m_maxspeed_backward;}
 
-     std::string get_geometry() const;
-     std::string length_str() const;
-
 
      inline std::string maxspeed_forward_str() const {
-         return boost::lexical_cast<std::string>(m_maxspeed_forward);
+         return number_str(m_maxspeed_forward);
      }
      inline std::string maxspeed_backward_str() const {
-         return boost::lexical_cast<std::string>(m_maxspeed_backward);
+         return number_str(m_maxspeed_backward);
      }
 
 
-     //! splits the way
-     std::vector<std::vector<Node*>> split_me();
-     std::string geometry_str(const std::vector<Node*> &) const;
-     std::string length_str(const std::vector<Node*> &) const;
+     /** @brief part of the way: the nodes [begin, end) of nodeRefs
+      *
+      * a split starts and ends at the ends of the way
+      * or at a node used by other ways
+      */
+     struct Split {
+         size_t begin;
+         size_t end;
+     };
+
+     /**
+      * splits the way
+      *
+      * @param[in] nodes  the nodes of the document (their uses)
+      * @param[out] splits  the parts of the way (cleared first)
+      */
+     void split_me(const Node_store &nodes, std::vector<Split> &splits) const;
+     std::string geometry_str(const Node_store &nodes, const Split &split) const;
+     //! length in degrees of the split
+     double length(const Node_store &nodes, const Split &split) const;
+     std::string length_str(const Node_store &nodes, const Split &split) const;
+     //! length in meters of the split on the WGS84 ellipsoid
+     double length_m(const Node_store &nodes, const Split &split) const;
+
+     //! position in the Node_store of the first node of the split
+     inline size_t first_node(const Split &split) const {return m_NodeRefs[split.begin];}
+     //! position in the Node_store of the last node of the split
+     inline size_t last_node(const Split &split) const {return m_NodeRefs[split.end - 1];}
 
      /**
       * to insert the relations tags
@@ -122,10 +154,10 @@ class Way : public Element {
 
 
  private:
-     /** references to node that its on the file */
-     std::vector<Node*> m_NodeRefs;
+     /** positions in the Node_store of the nodes that are on the file */
+     std::vector<size_t> m_NodeRefs;
 
-     /** node identifiers found as part of the way */
+     /** node identifiers found as part of the way (until the nodes are found) */
      std::vector<int64_t> m_node_ids;
 
      double m_maxspeed_forward;
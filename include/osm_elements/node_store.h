@@ -0,0 +1,160 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/** @file **/
+
+#ifndef SRC_NODE_STORE_H_
+#define SRC_NODE_STORE_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "./Node.h"
+#include "utilities/mapped_array.h"
+#include "utilities/rank_index.h"
+
+namespace osm2pgr {
+
+/** @brief the nodes kept by the document
+
+  What the ways need of a node, in parallel arrays
+  (the position of a node is the same in every array):
+  - the osm ids, sorted
+  - the coordinates in units of 1e-7 degrees (the OSM precision)
+  - the number of ways using the node
+
+  A lookup only reads the ids array (8 bytes per node),
+  with a binary search or, when asked, with a rank index
+  built once all the nodes are added.
+
+  Layouts:
+  - sparse: the arrays hold the nodes one after the other
+  - dense: the arrays are indexed by the osm id, there are no ids
+    (for planet size files, where most ids are used)
+
+  The arrays can be kept in memory mapped files instead of the memory.
+  The dense layout is only kept in files (the unused ids are holes),
+  --nodes-layout dense requires --nodes-file.
+
+  The attributes & tags of a node are only exported to the
+  osm_nodes and pointsofinterest tables (--addnodes),
+  they are not kept.
+
+  Concurrent calls to find are safe once the nodes are added.
+  */
+class Node_store {
+ public:
+     //! the node is not in the store
+     static const size_t npos = std::numeric_limits<size_t>::max();
+
+     Node_store() :
+         m_dense(false),
+         m_count(0),
+         m_use_rank_index(false),
+         m_negatives(0) {}
+
+     //! build a rank index on end_of_nodes
+     inline void use_rank_index(bool use) {m_use_rank_index = use;}
+
+     //! the arrays are indexed by the osm id
+     inline void dense(bool dense) {m_dense = dense;}
+
+     /**
+      * keep the arrays in the memory mapped files @b file.*
+      *
+      * @returns false when a file can not be created
+      */
+     bool map(const std::string &file);
+
+     //! appends the node (nodes come sorted by id)
+     void add(const Node &node);
+
+     //! no more nodes are added
+     void end_of_nodes();
+
+     //! position of the node, npos when the node is not in the store
+     size_t find(int64_t osm_id) const;
+
+     /**
+      * positions of the nodes @b osm_ids (npos for the missing nodes)
+      *
+      * The ids are sorted and merged with the ids of the store:
+      * the store is read in one forward pass instead of
+      * a binary search for each id.
+      */
+     void find(const std::vector<int64_t> &osm_ids, std::vector<size_t> &positions) const;
+
+     //! number of nodes added
+     inline size_t size() const {return m_count;}
+     inline bool empty() const {return m_count == 0;}
+
+     inline int64_t osm_id(size_t i) const {
+         return m_dense ? static_cast<int64_t>(i) : m_ids[i];
+     }
+     inline std::string lat(size_t i) const {return Node::coordinate_str(fixed_lat(i));}
+     inline std::string lon(size_t i) const {return Node::coordinate_str(fixed_lon(i));}
+
+     //! coordinates in units of 1e-7 degrees
+     inline int32_t fixed_lat(size_t i) const {return m_lats[i];}
+     inline int32_t fixed_lon(size_t i) const {return longitude(i);}
+
+     inline std::string geom_str(size_t i, const std::string separator) const {
+         return lon(i) + separator + lat(i);
+     }
+
+     //! distance in degrees between two nodes
+     double getLength(size_t i, size_t previous) const;
+
+     inline uint16_t incrementUse(size_t i) {return ++m_uses[i];}
+     inline uint16_t numsOfUse(size_t i) const {return m_uses[i];}
+
+ private:
+     /*
+      * the longitude is kept with its sign bit flipped:
+      * 0 is not a longitude, it marks the ids with no node (dense)
+      */
+     static inline int32_t flip(int32_t value) {
+         return static_cast<int32_t>(static_cast<uint32_t>(value) ^ 0x80000000u);
+     }
+     inline int32_t longitude(size_t i) const {return flip(m_lons[i]);}
+
+ private:
+     Mapped_array<int64_t> m_ids;
+     Mapped_array<int32_t> m_lats;
+     Mapped_array<int32_t> m_lons;
+     Mapped_array<uint16_t> m_uses;
+
+     bool m_dense;
+     size_t m_count;
+
+     bool m_use_rank_index;
+     Rank_index m_rank_index;
+     /*
+      * negative ids: they are before the ids of the rank index,
+      * the dense layout does not keep them
+      */
+     size_t m_negatives;
+};
+
+}  // end namespace osm2pgr
+#endif  // SRC_NODE_STORE_H_
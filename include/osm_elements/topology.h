@@ -0,0 +1,129 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/** @file **/
+
+#ifndef SRC_TOPOLOGY_H_
+#define SRC_TOPOLOGY_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "osm_elements/Way.h"
+
+class Thread_pool;
+
+namespace osm2pgr {
+
+class Node_store;
+
+/** @brief the vertices of the routing graph
+
+  The vertices are the ends of the splits of the ways
+  that have a configuration tag.
+
+  The ids are assigned before the ways are exported,
+  so the rows of the ways carry their source & target:
+  - a vertex already in the database keeps its id
+  - the other vertices are numbered in the order of their nodes
+
+  The splits with the nodes of a previous split are duplicated edges:
+  the splits are hashed on their node sequence while the vertices are
+  collected, only the first of the splits with the same nodes is exported.
+
+  @code
+  Topology topology;
+  topology.build(ways, nodes, pool);
+  topology.existing(osm_id, id, nodes);  // for each vertex of the database
+  topology.number(max_id + 1);
+  if (topology.is_duplicate(way, split)) continue;
+  auto source = topology.id(way.first_node(split));
+  @endcode
+
+  Concurrent calls to id are safe once the vertices are numbered.
+  */
+class Topology {
+ public:
+     Topology() : m_first_new(1) {}
+
+     //! collects the vertices & the duplicated splits of the @b ways
+     void build(
+             const std::vector<Way> &ways,
+             const Node_store &nodes,
+             Thread_pool &pool);
+
+     //! the vertex on the node @b osm_id is in the database with the id @b id
+     void existing(int64_t osm_id, int64_t id, const Node_store &nodes);
+
+     //! numbers the vertices that are not in the database from @b first_id
+     void number(int64_t first_id);
+
+     //! id of the vertex on the node at @b position of the store
+     int64_t id(size_t position) const;
+
+     //! number of vertices
+     inline size_t size() const {return m_positions.size();}
+
+     //! position in the store of the node of the i-th vertex
+     inline size_t position(size_t i) const {return m_positions[i];}
+     //! id of the i-th vertex
+     inline int64_t vertex_id(size_t i) const {return m_ids[i];}
+     //! the i-th vertex is not in the database
+     inline bool is_new(size_t i) const {return m_ids[i] >= m_first_new;}
+
+     //! the nodes of the @b split of the @b way are the nodes of a previous split
+     bool is_duplicate(const Way &way, const Way::Split &split) const;
+
+     //! number of duplicated splits
+     inline size_t duplicates() const {return m_duplicates.size();}
+
+     /*
+      * used by build, public for the tests:
+      * they give different node sequences the same hash
+      */
+     //! a split & the hash of its node sequence
+     struct Edge {
+         uint64_t hash;
+         const Way *way;
+         size_t begin;
+         size_t end;
+     };
+
+     //! keeps the first split of the @b edges with the same nodes
+     void find_duplicates(std::vector<Edge> &edges);
+
+ private:
+     //! index of the vertex on the node at @b position, size() when there is none
+     size_t find(size_t position) const;
+
+ private:
+     //! sorted positions of the nodes of the vertices
+     std::vector<size_t> m_positions;
+     std::vector<int64_t> m_ids;
+     int64_t m_first_new;
+     //! sorted (way, begin of the split) of the duplicated splits
+     std::vector<std::pair<const Way*, size_t>> m_duplicates;
+};
+
+}  // end namespace osm2pgr
+#endif  // SRC_TOPOLOGY_H_
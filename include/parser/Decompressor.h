@@ -0,0 +1,97 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+/** @file **/
+
+#ifndef SRC_DECOMPRESSOR_H_
+#define SRC_DECOMPRESSOR_H_
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utilities/bounded_queue.h"
+
+namespace xml {
+
+/** @brief decompresses a .gz or .bz2 file on its own thread
+
+  The decompressed data is delivered in buffers of @b buffer_size bytes
+  thru a bounded queue, so decompression and parsing overlap
+  and at most @b queue_size buffers are waiting to be parsed.
+
+  Concatenated streams (as written by pigz / pbzip2) are handled.
+*/
+class Decompressor {
+ public:
+     enum Format {NONE, GZIP, BZIP2};
+
+     /** @brief the compression of the file, based on its magic number
+      *
+      * the file position is left at the beginning of the file
+      */
+     static Format format(FILE *fp);
+
+     /**
+      * @param fp  the compressed file, positioned at its beginning
+      * @param format  GZIP or BZIP2
+      * @param buffer_size  size of the decompressed buffers
+      * @param queue_size  buffers that can be waiting to be parsed
+      */
+     Decompressor(FILE *fp, Format format, size_t buffer_size, size_t queue_size = 4);
+
+     Decompressor(const Decompressor&) = delete;
+     Decompressor& operator=(const Decompressor&) = delete;
+
+     //! stops the decompressing thread
+     ~Decompressor();
+
+     /** @brief the next decompressed buffer
+      *
+      * @returns false when there is no more data (or on error)
+      */
+     bool next(std::vector<char> &buffer);
+
+     //! empty when the decompression succeeded
+     inline const std::string& error() const {return m_error;}
+
+     //! compressed bytes consumed so far
+     inline size_t compressed_bytes() const {return m_compressed_bytes;}
+
+ private:
+     void run();
+     void gunzip();
+     void bunzip2();
+     size_t read(std::vector<char> &in);
+
+ private:
+     FILE *m_fp;
+     Format m_format;
+     size_t m_buffer_size;
+     Bounded_queue<std::vector<char>> m_queue;
+     std::atomic<size_t> m_compressed_bytes;
+     std::string m_error;
+     std::thread m_thread;
+};
+
+}  // end namespace xml
+#endif  // SRC_DECOMPRESSOR_H_
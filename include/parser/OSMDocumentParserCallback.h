@@ -56,24 +56,25 @@ class OSMDocumentParserCallback :
  public:
     /**
      *    Constructor
+     *    @param doc  the document
+     *    @param relations_only  the nodes & ways are already in the document,
+     *                           only its relations section is parsed
      */
-    explicit OSMDocumentParserCallback(OSMDocument& doc) :
+    explicit OSMDocumentParserCallback(OSMDocument& doc, bool relations_only = false) :
         m_rDocument(doc),
         m_pActRelation(0),
         last_node(nullptr),
         last_way(nullptr),
         last_relation(nullptr),
-        m_line(0),
-        m_section(1) {
+        m_first_section(relations_only ? 3 : 1),
+        m_section(m_first_section) {
     }
- private:
-    void show_progress();
-
  private:
     Node *last_node;
     Way *last_way;
     Relation* last_relation;
-    size_t m_line;
+    //! 1: nodes, 2: ways, 3: relations
+    int m_first_section;
     int m_section;
 };  // class OSMDocumentParserCallback
 
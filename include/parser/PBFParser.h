@@ -0,0 +1,77 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+/** @file **/
+
+#ifndef SRC_PBFPARSER_H_
+#define SRC_PBFPARSER_H_
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "./XMLParser.h"
+
+namespace pbf {
+
+/** @brief reader for the OSM PBF (protocol buffer binary) format
+
+  https://wiki.openstreetmap.org/wiki/PBF_Format
+
+  The file blobs are decompressed and decoded on a pool of worker threads,
+  the decoded elements are handed to the callback in file order
+  as the same start/end element events the XML parser generates:
+
+  @code
+  <osm>
+    <node id=".." lat=".." lon=".."> <tag k=".." v=".."/> </node>
+    <way id=".."> <nd ref=".."/> <tag k=".." v=".."/> </way>
+    <relation id=".."> <member type=".." ref=".." role=".."/> <tag k=".." v=".."/> </relation>
+  </osm>
+  @endcode
+
+  so any xml::XMLParserCallback can be used to read a .osm.pbf file.
+
+  Supported blob compressions: raw and zlib.
+*/
+class PBFParser {
+ public:
+     /**
+      * @param threads  number of decoding threads (0: one per core)
+      */
+     explicit PBFParser(size_t threads = 0);
+
+     /**
+       Parse a file from the file system
+
+       \param rCallback [IN] the parser callback
+       \param chFileName [IN] name of the file to be parsed
+
+       \return 0: everything ok, 1: file not found, 2: parsing error
+      */
+     int Parse(xml::XMLParserCallback& rCallback, const char* chFileName);
+
+     /** is the file name of a PBF file? (ends with .pbf) */
+     static bool is_pbf(const std::string &file_name);
+
+ private:
+     size_t m_threads;
+};
+
+}  // end namespace pbf
+#endif  // SRC_PBFPARSER_H_
@@ -0,0 +1,87 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+/** @file **/
+
+#ifndef SRC_PARALLELXMLPARSER_H_
+#define SRC_PARALLELXMLPARSER_H_
+#pragma once
+
+#include <cstddef>
+
+namespace osm2pgr {
+
+class OSMDocument;
+
+/** @brief parses an OSM XML file on several threads
+
+  The file is memory mapped and its sections are found
+  (the elements of an OSM file are sorted: nodes, ways, relations).
+
+  - the nodes section and the ways section are cut in slices
+    at the start of a @b \<node or a @b \<way element
+  - the slices are parsed concurrently, each by its own expat parser
+  - the parsed slices are added to the OSMDocument in file order,
+    so the document is the same as the one built by a single parser
+  - the ways are parsed once all the nodes are in the document,
+    because the ways refer to the nodes
+  - the relations modify the ways they refer to in file order,
+    the relations section is parsed by a single parser
+
+  Compressed files (and files that can not be mapped)
+  are parsed by a single parser.
+*/
+class ParallelXMLParser {
+ public:
+     /**
+      * @param document  the document being built
+      * @param threads  number of parsing threads (0: one per core)
+      * @param read_size  size of the slices
+      */
+     ParallelXMLParser(OSMDocument &document, size_t threads, size_t read_size);
+
+     /**
+       Parse a file from the file system
+
+       \param chFileName [IN] name of the file to be parsed
+
+       \return 0: everything ok, 1: file not found, 2: parsing error
+      */
+     int Parse(const char* chFileName);
+
+     //! bytes parsed by the last Parse
+     inline size_t bytes() const {return m_bytes;}
+     //! seconds spent on the last Parse
+     inline double seconds() const {return m_seconds;}
+     //! throughput of the last Parse in MB/s
+     double throughput() const;
+
+ private:
+     bool parse_mapped(const char *data, size_t size);
+
+ private:
+     OSMDocument &m_document;
+     size_t m_threads;
+     size_t m_read_size;
+     size_t m_bytes;
+     double m_seconds;
+};
+
+}  // end namespace osm2pgr
+#endif  // SRC_PARALLELXMLPARSER_H_
@@ -0,0 +1,103 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+/** @file **/
+
+#ifndef SRC_ROUTABLESCANCALLBACK_H_
+#define SRC_ROUTABLESCANCALLBACK_H_
+#pragma once
+
+#include <string.h>
+#include <cstdint>
+#include <vector>
+#include "./XMLParser.h"
+#include "utilities/id_bitmap.h"
+
+namespace osm2pgr {
+
+class Configuration;
+
+/**
+    First pass over an osm file: finds the nodes used by the routable ways
+
+    A way is routable when
+    - one of its tags is in the configuration
+    - or it is member of a relation with a tag in the configuration
+
+    The relations come after the ways, so when a relation makes routable
+    a way that is not routable by its own tags, the ways are read again:
+
+    @code
+    RoutableScanCallback scan(config);
+    parser.Parse(scan, file);
+    if (scan.members_pending()) {
+        scan.start_members_pass();
+        parser.Parse(scan, file);
+    }
+    @endcode
+*/
+class RoutableScanCallback :
+  public xml::XMLParserCallback {
+ public:
+    explicit RoutableScanCallback(const Configuration &config) :
+        m_config(config),
+        m_members_pass(false),
+        m_members_pending(false),
+        m_in_way(false),
+        m_in_relation(false),
+        m_way_id(0),
+        m_routable(false) {
+    }
+
+    virtual void StartElement(const char *name, const char** atts);
+    virtual void EndElement(const char* name);
+
+    //! relations made routable ways that are not routable by their tags
+    inline bool members_pending() const {return m_members_pending;}
+
+    //! the next parse only collects the nodes of those ways
+    inline void start_members_pass() {m_members_pass = true;}
+
+    //! nodes used by the routable ways
+    inline Id_bitmap& nodes() {return m_nodes;}
+
+    //! the routable ways
+    inline Id_bitmap& ways() {return m_ways;}
+
+ private:
+    const Configuration &m_config;
+
+    Id_bitmap m_nodes;
+    Id_bitmap m_ways;
+    //! ways routable only thru a relation
+    Id_bitmap m_member_ways;
+
+    bool m_members_pass;
+    bool m_members_pending;
+
+    bool m_in_way;
+    bool m_in_relation;
+    int64_t m_way_id;
+    bool m_routable;
+    std::vector<int64_t> m_refs;
+};  // class RoutableScanCallback
+
+}  // end namespace osm2pgr
+
+#endif  // SRC_ROUTABLESCANCALLBACK_H_
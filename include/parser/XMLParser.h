@@ -23,6 +23,11 @@
 #define SRC_XMLPARSER_H_
 
 #include <expat.h>
+#include <cstdio>
+#include <cstddef>
+#include <chrono>
+#include <string>
+#include "parser/Decompressor.h"
 
 
 namespace xml {
@@ -61,11 +66,37 @@ class XMLParserCallback {
   Dependencies:
   - link with xmlparse.lib
   - uses xmlparse.dll
+
+  Input:
+  - the file is read in blocks of @b read_size bytes directly into
+    the expat buffer (XML_GetBuffer / XML_ParseBuffer).
+  - the pieces given to ParseSlice are copied by expat
+    into its buffer (XML_Parse).
+  - gzip and bzip2 compressed files (.osm.gz, .osm.bz2) are recognized
+    by their magic number and decompressed on a separate thread,
+    the decompressed blocks of @b read_size bytes reach expat
+    thru a bounded queue.
+
+  Progress:
+  - when wanted, the progress is reported from the position in the file
+    (the compressed position for compressed files)
+    with the throughput and the estimated remaining time.
 */
 class XMLParser {
  public:
   //! Constructor
-    XMLParser() {}
+    explicit XMLParser(
+            size_t read_size = 8 * 1024 * 1024,
+            bool show_progress = false) :
+        m_ParserCtxt(nullptr),
+        m_read_size(read_size ? read_size : 1024 * 1024),
+        m_show_progress(show_progress),
+        m_bytes(0),
+        m_seconds(0),
+        m_callback(nullptr),
+        m_decompressor(nullptr),
+        m_file_size(0),
+        m_elements(0) {}
     //! Destructor
     virtual ~XMLParser() {}
 
@@ -79,9 +110,64 @@ class XMLParser {
    */  
     int Parse(XMLParserCallback& rCallback, const char* chFileName);
 
+  /**
+    Parse a piece of a document that holds complete elements,
+    the piece is parsed as the content of a @b root element
+
+    \param rCallback [IN] the parser callback
+    \param data [IN] the piece of the document
+    \param size [IN] the size of the piece
+    \param root [IN] name of the enclosing element
+
+    \return true: everything ok, false: parsing error
+   */
+    bool ParseSlice(
+            XMLParserCallback& rCallback,
+            const char *data, size_t size,
+            const std::string &root);
+
+    //! bytes handed to expat by the last Parse
+    inline size_t bytes() const {return m_bytes;}
+    //! seconds spent on the last Parse
+    inline double seconds() const {return m_seconds;}
+    //! throughput of the last Parse in MB/s
+    double throughput() const;
+
+ private:
+    //! expat callbacks, the user data is the XMLParser
+    static void XMLCALL startElement(void *userData, const char *name, const char **atts);
+    static void XMLCALL endElement(void *userData, const char *name);
+
+    //! bytes of the file consumed so far
+    size_t position() const;
+    void show_progress(bool done);
+
+    bool parse_stream(FILE *fp);
+    bool parse_compressed(FILE *fp, Decompressor::Format format);
+
+    /**
+      The only place where data is handed to expat
+
+      \param data [IN] the data, nullptr: already in the expat buffer
+      \param len [IN] the data length
+      \param done [IN] last piece of data
+     */
+    bool feed(const char *data, size_t len, bool done);
+
  private:
     //! the expat parser object / imported from „expat.h“
     XML_Parser            m_ParserCtxt;
+    size_t m_read_size;
+    bool m_show_progress;
+    size_t m_bytes;
+    double m_seconds;
+
+    XMLParserCallback *m_callback;
+    const Decompressor *m_decompressor;
+    size_t m_file_size;
+    size_t m_elements;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_last_report;
 };
 
 }  // end namespace xml
@@ -0,0 +1,85 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+/** @file **/
+
+#ifndef SRC_BOUNDED_QUEUE_H_
+#define SRC_BOUNDED_QUEUE_H_
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/** @brief queue connecting a producer thread with a consumer thread
+ *
+ * - push blocks while the queue is full
+ * - pop blocks while the queue is empty
+ * - close wakes up both sides:
+ *   - push refuses new items
+ *   - pop returns the remaining items and then fails
+ */
+template <typename T>
+class Bounded_queue {
+ public:
+     explicit Bounded_queue(size_t capacity) :
+         m_capacity(capacity ? capacity : 1),
+         m_closed(false) {}
+
+     Bounded_queue(const Bounded_queue&) = delete;
+     Bounded_queue& operator=(const Bounded_queue&) = delete;
+
+     /** @returns false when the queue was closed */
+     bool push(T item) {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_not_full.wait(lock, [this] {return m_closed || m_items.size() < m_capacity;});
+         if (m_closed) return false;
+         m_items.push_back(std::move(item));
+         m_not_empty.notify_one();
+         return true;
+     }
+
+     /** @returns false when the queue is closed and empty */
+     bool pop(T &item) {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_not_empty.wait(lock, [this] {return m_closed || !m_items.empty();});
+         if (m_items.empty()) return false;
+         item = std::move(m_items.front());
+         m_items.pop_front();
+         m_not_full.notify_one();
+         return true;
+     }
+
+     void close() {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_closed = true;
+         m_not_empty.notify_all();
+         m_not_full.notify_all();
+     }
+
+ private:
+     size_t m_capacity;
+     bool m_closed;
+     std::deque<T> m_items;
+     std::mutex m_mutex;
+     std::condition_variable m_not_empty;
+     std::condition_variable m_not_full;
+};
+
+#endif  // SRC_BOUNDED_QUEUE_H_
@@ -0,0 +1,85 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+/** @file **/
+
+#ifndef SRC_ID_BITMAP_H_
+#define SRC_ID_BITMAP_H_
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+/** @brief set of osm ids, one bit per id
+ *
+ * The bits are kept in pages of 64K ids,
+ * a page is allocated when one of its ids is set,
+ * so sparse ranges of ids cost nothing.
+ *
+ * Negative ids (new objects of an editor) are kept in a hash set.
+ *
+ * Concurrent calls to test are safe while no id is set.
+ */
+class Id_bitmap {
+ public:
+     Id_bitmap() : m_count(0) {}
+
+     Id_bitmap(Id_bitmap&&) = default;
+     Id_bitmap& operator=(Id_bitmap&&) = default;
+
+     void set(int64_t id) {
+         if (id < 0) {
+             if (m_negative.insert(id).second) ++m_count;
+             return;
+         }
+         auto page = static_cast<size_t>(id >> PAGE_BITS);
+         if (page >= m_pages.size()) m_pages.resize(page + 1);
+         if (!m_pages[page]) m_pages[page].reset(new uint64_t[PAGE_WORDS]());
+
+         auto &word = m_pages[page][(id & PAGE_MASK) >> 6];
+         auto bit = uint64_t(1) << (id & 63);
+         if (!(word & bit)) {
+             word |= bit;
+             ++m_count;
+         }
+     }
+
+     bool test(int64_t id) const {
+         if (id < 0) return m_negative.count(id) != 0;
+         auto page = static_cast<size_t>(id >> PAGE_BITS);
+         if (page >= m_pages.size() || !m_pages[page]) return false;
+         return (m_pages[page][(id & PAGE_MASK) >> 6] >> (id & 63)) & 1;
+     }
+
+     //! number of ids in the set
+     inline size_t size() const {return m_count;}
+
+ private:
+     static const int PAGE_BITS = 16;
+     static const int64_t PAGE_MASK = (int64_t(1) << PAGE_BITS) - 1;
+     static const size_t PAGE_WORDS = (size_t(1) << PAGE_BITS) / 64;
+
+     std::vector<std::unique_ptr<uint64_t[]>> m_pages;
+     std::unordered_set<int64_t> m_negative;
+     size_t m_count;
+};
+
+#endif  // SRC_ID_BITMAP_H_
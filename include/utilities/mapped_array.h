@@ -0,0 +1,153 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/** @file **/
+
+#ifndef SRC_MAPPED_ARRAY_H_
+#define SRC_MAPPED_ARRAY_H_
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WITH_MMAP
+#endif
+
+#include <fcntl.h>
+#ifdef WITH_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+/** @brief array kept in memory or in a memory mapped file
+ *
+ * By default the elements are in a std::vector.
+ *
+ * Once mapped, the elements are in a file that is mapped in memory:
+ * the OS page cache decides which pages stay resident,
+ * so the array can be larger than the memory.
+ * The file is removed as soon as it is created (it is not left behind).
+ *
+ * The new elements of resize are zero
+ * (in a file they are holes: they take no disk space).
+ */
+template <typename T>
+class Mapped_array {
+ public:
+     Mapped_array() : m_data(nullptr), m_size(0), m_capacity(0), m_fd(-1) {}
+     ~Mapped_array() {unmap();}
+
+     Mapped_array(const Mapped_array&) = delete;
+     Mapped_array& operator=(const Mapped_array&) = delete;
+
+     /**
+      * The next elements are kept in @b file
+      *
+      * @returns false when the file can not be created (errno is set)
+      */
+     bool map(const std::string &file) {
+#ifdef WITH_MMAP
+         auto fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+         if (fd < 0) return false;
+         unlink(file.c_str());
+
+         unmap();
+         m_fd = fd;
+         auto elements = m_vector.size();
+         reserve(std::max(elements, static_cast<size_t>(1024 * 1024)));
+         std::copy(m_vector.begin(), m_vector.end(), m_data);
+         m_size = elements;
+         std::vector<T>().swap(m_vector);
+         return true;
+#else
+         (void)file;
+         return false;
+#endif
+     }
+
+     inline bool is_mapped() const {return m_fd >= 0;}
+
+     void push_back(const T &value) {
+         if (!is_mapped()) {
+             m_vector.push_back(value);
+             return;
+         }
+         if (m_size == m_capacity) reserve(2 * m_capacity);
+         m_data[m_size++] = value;
+     }
+
+     void resize(size_t size) {
+         if (!is_mapped()) {
+             m_vector.resize(size);
+             return;
+         }
+         if (size > m_capacity) reserve(std::max(size, 2 * m_capacity));
+         if (size < m_size) std::fill(m_data + size, m_data + m_size, T());
+         m_size = size;
+     }
+
+     inline size_t size() const {return is_mapped() ? m_size : m_vector.size();}
+     inline bool empty() const {return size() == 0;}
+
+     inline T* begin() {return is_mapped() ? m_data : m_vector.data();}
+     inline T* end() {return begin() + size();}
+     inline const T* begin() const {return is_mapped() ? m_data : m_vector.data();}
+     inline const T* end() const {return begin() + size();}
+
+     inline T& operator[](size_t i) {return begin()[i];}
+     inline const T& operator[](size_t i) const {return begin()[i];}
+
+ private:
+     void reserve(size_t capacity) {
+#ifdef WITH_MMAP
+         if (m_data) munmap(m_data, m_capacity * sizeof(T));
+         m_data = nullptr;
+         if (ftruncate(m_fd, static_cast<off_t>(capacity * sizeof(T))) != 0) throw std::bad_alloc();
+         auto addr = mmap(nullptr, capacity * sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+         if (addr == MAP_FAILED) throw std::bad_alloc();
+         m_data = static_cast<T*>(addr);
+         m_capacity = capacity;
+#else
+         (void)capacity;
+#endif
+     }
+
+     void unmap() {
+#ifdef WITH_MMAP
+         if (m_data) munmap(m_data, m_capacity * sizeof(T));
+         if (m_fd >= 0) close(m_fd);
+#endif
+         m_data = nullptr;
+         m_fd = -1;
+         m_size = m_capacity = 0;
+     }
+
+ private:
+     std::vector<T> m_vector;
+     T *m_data;
+     size_t m_size;
+     size_t m_capacity;
+     int m_fd;
+};
+
+#endif  // SRC_MAPPED_ARRAY_H_
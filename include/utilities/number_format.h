@@ -0,0 +1,78 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/** @file **/
+
+#ifndef SRC_NUMBER_FORMAT_H_
+#define SRC_NUMBER_FORMAT_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Numbers written in a buffer given by the caller:
+ * the functions return the end of the characters written
+ * (the buffer is not null terminated)
+ *
+ * The buffer must hold NUMBER_SIZE characters.
+ */
+
+const size_t NUMBER_SIZE = 32;
+
+//! 1234, -1234
+char*
+format_int(int64_t value, char *buffer);
+
+/**
+ * fixed point value with @b decimals decimals
+ *   format_fixed(451234567, 7) -> "45.1234567"
+ */
+char*
+format_fixed(int64_t value, int decimals, char *buffer);
+
+/**
+ * shortest decimal that reads back as @b value
+ *   0.1 -> "0.1", 40 -> "40", 1e+300 -> "1e+300"
+ *
+ * NaN and infinities are written as postgreSQL reads them
+ */
+char*
+format_double(double value, char *buffer);
+
+
+template <typename T>
+inline
+std::string
+number_str(T value) {
+    char buffer[NUMBER_SIZE];
+    return std::string(buffer, format_int(static_cast<int64_t>(value), buffer));
+}
+
+template <>
+inline
+std::string
+number_str(double value) {
+    char buffer[NUMBER_SIZE];
+    return std::string(buffer, format_double(value, buffer));
+}
+
+#endif  // SRC_NUMBER_FORMAT_H_
@@ -23,7 +23,10 @@
 #pragma once
 
 
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 template < typename T1 , typename T2>
@@ -49,4 +52,37 @@ print_progress(T1 wantProgress, T2 currentProgress) {
         << " (" << static_cast<int>(100 * percent) << "%)"
         << " Total processed: " << currentProgress << std::flush;
 }
+
+/*
+ * progress of reading a file of @b total bytes (0: unknown size)
+ */
+inline
+void
+print_read_progress(size_t total, size_t current, double seconds) {
+    double mb = static_cast<double>(current) / (1024 * 1024);
+    double rate = seconds > 0 ? mb / seconds : 0;
+
+    std::ostringstream line;
+    line << "\r";
+    if (total) {
+        int length = 50;
+        double percent = std::min(1.0, static_cast<double>(current) / static_cast<double>(total));
+        int fillerLength = static_cast<int>(percent * length);
+        line << "[" << std::string(static_cast<size_t>(fillerLength), '*')
+            << "|" << std::string(static_cast<size_t>(length - fillerLength), ' ') << "]"
+            << " (" << static_cast<int>(100 * percent) << "%) ";
+    }
+    line << std::fixed << std::setprecision(1)
+        << mb << " MB " << rate << " MB/s";
+    if (total && rate > 0) {
+        auto eta = static_cast<size_t>(
+                static_cast<double>(total - std::min(total, current)) / (1024 * 1024) / rate);
+        line << " ETA "
+            << eta / 3600 << ":"
+            << std::setfill('0') << std::setw(2) << (eta / 60) % 60 << ":"
+            << std::setw(2) << eta % 60;
+    }
+    std::cout << line.str() << "   " << std::flush;
+}
+
 #endif  // SRC_PRINT_PROGRESS_H_
@@ -0,0 +1,113 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+/** @file **/
+
+#ifndef SRC_RANK_INDEX_H_
+#define SRC_RANK_INDEX_H_
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** @brief position of an id in a sorted array of ids, in constant time
+ *
+ * A succinct rank index:
+ * - one bit per id from 0 up to the largest id
+ * - the number of bits set before every block of 512 bits
+ *
+ * The position of an id in the array is the number of ids
+ * smaller than it: the count of its block plus the bits set
+ * before it in the block (at most 8 popcounts).
+ *
+ * Memory: about 1.13 bits per id up to the largest id,
+ * whatever the number of ids in the array.
+ */
+class Rank_index {
+ public:
+     Rank_index() = default;
+
+     /**
+      * @param begin, end  strictly increasing, non negative ids
+      */
+     template <typename Iterator>
+     void build(Iterator begin, Iterator end) {
+         m_words.clear();
+         m_blocks.clear();
+         if (begin == end) return;
+
+         auto last = *(end - 1);
+         m_words.assign(static_cast<size_t>(last >> 6) + 1, 0);
+         for (auto it = begin; it != end; ++it) {
+             m_words[static_cast<size_t>(*it >> 6)] |= uint64_t(1) << (*it & 63);
+         }
+
+         m_blocks.reserve(m_words.size() / BLOCK_WORDS + 1);
+         uint64_t count = 0;
+         for (size_t i = 0; i < m_words.size(); ++i) {
+             if (i % BLOCK_WORDS == 0) m_blocks.push_back(count);
+             count += popcount(m_words[i]);
+         }
+     }
+
+     inline bool empty() const {return m_words.empty();}
+
+     /**
+      * @param[in] id  the id searched
+      * @param[out] rank  position of the id in the array
+      * @returns false when the id is not in the array
+      */
+     bool find(int64_t id, size_t &rank) const {
+         if (id < 0) return false;
+         auto word = static_cast<size_t>(id >> 6);
+         if (word >= m_words.size()) return false;
+
+         auto bit = uint64_t(1) << (id & 63);
+         if (!(m_words[word] & bit)) return false;
+
+         auto count = m_blocks[word / BLOCK_WORDS];
+         for (auto i = word - word % BLOCK_WORDS; i < word; ++i) {
+             count += popcount(m_words[i]);
+         }
+         count += popcount(m_words[word] & (bit - 1));
+         rank = static_cast<size_t>(count);
+         return true;
+     }
+
+ private:
+     static inline uint64_t popcount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+         return static_cast<uint64_t>(__builtin_popcountll(word));
+#else
+         uint64_t count = 0;
+         for (; word; word &= word - 1) ++count;
+         return count;
+#endif
+     }
+
+ private:
+     static const size_t BLOCK_WORDS = 8;
+
+     std::vector<uint64_t> m_words;
+     std::vector<uint64_t> m_blocks;
+};
+
+#endif  // SRC_RANK_INDEX_H_
@@ -0,0 +1,104 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+/** @file **/
+
+#ifndef SRC_THREAD_POOL_H_
+#define SRC_THREAD_POOL_H_
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/** @brief fixed size pool of worker threads
+ *
+ * Tasks are run in submission order by the first idle worker.
+ * The caller keeps the returned futures to collect the results
+ * (and the exceptions) in the order it needs them.
+ */
+class Thread_pool {
+ public:
+     explicit Thread_pool(size_t n_threads) :
+         m_stop(false) {
+             if (n_threads == 0) n_threads = 1;
+             for (size_t i = 0; i < n_threads; ++i) {
+                 m_workers.emplace_back([this] {work();});
+             }
+         }
+
+     Thread_pool(const Thread_pool&) = delete;
+     Thread_pool& operator=(const Thread_pool&) = delete;
+
+     /** waits for the queued tasks to finish */
+     ~Thread_pool() {
+         {
+             std::lock_guard<std::mutex> lock(m_mutex);
+             m_stop = true;
+         }
+         m_condition.notify_all();
+         for (auto &worker : m_workers) worker.join();
+     }
+
+     inline size_t size() const {return m_workers.size();}
+
+     template <typename F>
+         std::future<typename std::result_of<F()>::type>
+         submit(F task) {
+             typedef typename std::result_of<F()>::type R;
+             auto packaged = std::make_shared<std::packaged_task<R()>>(std::move(task));
+             auto result = packaged->get_future();
+             {
+                 std::lock_guard<std::mutex> lock(m_mutex);
+                 m_tasks.push_back([packaged] {(*packaged)();});
+             }
+             m_condition.notify_one();
+             return result;
+         }
+
+ private:
+     void work() {
+         while (true) {
+             std::function<void()> task;
+             {
+                 std::unique_lock<std::mutex> lock(m_mutex);
+                 m_condition.wait(lock, [this] {return m_stop || !m_tasks.empty();});
+                 if (m_tasks.empty()) return;
+                 task = std::move(m_tasks.front());
+                 m_tasks.pop_front();
+             }
+             task();
+         }
+     }
+
+ private:
+     std::vector<std::thread> m_workers;
+     std::deque<std::function<void()>> m_tasks;
+     std::mutex m_mutex;
+     std::condition_variable m_condition;
+     bool m_stop;
+};
+
+#endif  // SRC_THREAD_POOL_H_
@@ -26,5 +26,3 @@
     
 std::string 
 comma_separated(const std::vector<std::string> &columns);
-std::string 
-tab_separated(const std::vector<std::string> &columns);
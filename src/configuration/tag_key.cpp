@@ -19,7 +19,6 @@
  ***************************************************************************/
 
 #include "configuration/tag_key.h"
-#include "utilities/utilities.h"
 #include <boost/lexical_cast.hpp>
 #include <string>
 #include <map>
@@ -63,9 +62,9 @@ Tag_key::get(const Tag &tag, const std::string &str) const {
 }
 
 
-std::vector<std::string> 
+std::vector<std::vector<std::string>>
 Tag_key::values(const std::vector<std::string> &columns) const {
-    std::vector<std::string> export_values;
+    std::vector<std::vector<std::string>> export_values;
 
     for (const auto &item : m_Tag_values) {
         auto row = item.second.values(columns, true);
@@ -76,7 +75,7 @@ Tag_key::values(const std::vector<std::string> &columns) const {
         if (row[5] == "") row[5] = row[4]; 
         if (row[6] == "") row[6] = row[4];
         if (row[7] == "") row[7] = "N"; 
-        export_values.push_back(tab_separated(row));
+        export_values.push_back(row);
     }
     return export_values;
 }
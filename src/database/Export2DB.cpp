@@ -21,48 +21,116 @@
 
 #include "database/Export2DB.h"
 #include "database/table_management.h"
+#include "database/binary_copy_writer.h"
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <future>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "utilities/print_progress.h"
 #include "utilities/prog_options.h"
 #include "utilities/utilities.h"
+#include "utilities/thread_pool.h"
+#include "utilities/number_format.h"
 
 #include "boost/algorithm/string/replace.hpp"
 
 
 namespace osm2pgr {
 
-template <typename T>
-static
-std::string
-TO_STR(const T &x) {
-    return  boost::lexical_cast<std::string>(x);
-}
-
-
 Export2DB::Export2DB(const  po::variables_map &vm, const std::string &connection) :
     m_vm(vm),
     conninf(connection),
-    m_tables(vm)
+    m_tables(vm),
+    m_copy_connection(nullptr)
 {
+    /*
+     * load profile: the settings are given to every session
+     */
+    if (m_vm.count("bulk-load")) {
+        conninf += " options='-c synchronous_commit=off -c maintenance_work_mem="
+            + m_vm["maintenance-work-mem"].as<std::string>() + "'";
+    }
 }
 
 Export2DB::~Export2DB() {
-#if 0
-    PQfinish(mycon);
-#endif
+    if (m_copy_connection) PQfinish(m_copy_connection);
+}
+
+
+/*
+ * The sessions are opened once and used for the whole run:
+ * a connection costs a handshake (and a TLS negotiation).
+ * A broken session is opened again.
+ */
+pqxx::connection&
+Export2DB::connection() const {
+    if (!m_connection || !m_connection->is_open()) {
+        m_connection.reset(new pqxx::connection(conninf));
+    }
+    return *m_connection;
+}
+
+
+PGconn*
+Export2DB::copy_connection() const {
+    if (m_copy_connection && PQstatus(m_copy_connection) != CONNECTION_OK) {
+        PQreset(m_copy_connection);
+    }
+    if (!m_copy_connection) {
+        m_copy_connection = PQconnectdb(conninf.c_str());
+    }
+    if (PQstatus(m_copy_connection) != CONNECTION_OK) {
+        throw std::runtime_error(PQerrorMessage(m_copy_connection));
+    }
+    return m_copy_connection;
 }
 
+
+/*
+ * The table is prepared (created or truncated) and copied in one transaction:
+ * with --bulk-load the rows are copied frozen,
+ * reading them later does not rewrite the pages to set their hint bits.
+ */
+void
+Export2DB::begin_copy(
+        PGconn *conn,
+        const std::string &prepare,
+        const std::string &table,
+        const std::string &columns,
+        bool binary) const {
+    std::vector<std::string> options;
+    if (binary) options.push_back("FORMAT binary");
+    if (prepare != "" && m_vm.count("bulk-load")) options.push_back("FREEZE");
+
+    std::string copy_sql("COPY " + table + " (" + columns + ") FROM STDIN");
+    if (!options.empty()) copy_sql += " WITH (" + comma_separated(options) + ")";
+
+    Copy_writer::begin(conn, prepare, copy_sql);
+}
+
+
+bool
+Export2DB::end_copy(PGconn *conn) const {
+    auto ok = Copy_writer::end(conn);
+    PQclear(PQexec(conn, ok ? "COMMIT" : "ROLLBACK"));
+    return ok;
+}
+
+
 int Export2DB::connect() {
     try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
+        pqxx::work Xaction(connection());
         cout << "connection success"<< endl;
         return 0;
 
@@ -76,8 +144,7 @@ int Export2DB::connect() {
 bool
 Export2DB::has_extension(const std::string &name) const {
     try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
+        pqxx::work Xaction(connection());
         std::string sql = "SELECT * FROM pg_extension WHERE extname = '" + name + "'";
         auto result = Xaction.exec(sql);
         return result.size() == 1;
@@ -93,8 +160,7 @@ Export2DB::has_extension(const std::string &name) const {
 bool
 Export2DB::install_postGIS() const {
     try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
+        pqxx::work Xaction(connection());
         Xaction.exec("CREATE EXTENSION postgis");
         Xaction.exec("CREATE EXTENSION hstore");
         Xaction.commit();
@@ -114,8 +180,7 @@ Export2DB::install_postGIS() const {
 
 bool Export2DB::exists(const std::string &table) const {
     try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
+        pqxx::work Xaction(connection());
 
         Xaction.exec(std::string("SELECT '") + table + "'::regclass");
         std::cout << "TABLE: " << vertices().addSchema() << " already exists.\n";
@@ -128,31 +193,27 @@ bool Export2DB::exists(const std::string &table) const {
 
 
 void Export2DB::createTables() const {
-    try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
-
-        if (!exists(vertices().addSchema())) {
-            Xaction.exec(vertices().create());
-            std::cout << "TABLE: " << vertices().addSchema() << " created ... OK.\n";
-        }
-
-        if (!exists(ways().addSchema())) {
-            Xaction.exec(ways().create());
-            std::cout << "TABLE: " << ways().addSchema() << " created ... OK.\n";
+    /*
+     * the tables are looked for before the transaction:
+     * the session runs one transaction at a time
+     */
+    auto missing = [this](const std::vector<Table> &tables) {
+        std::vector<Table> result;
+        for (const auto &table : tables) {
+            if (!exists(table.addSchema())) result.push_back(table);
         }
+        return result;
+    };
 
-        if (!exists(pois().addSchema())) {
-            Xaction.exec(pois().create());
-            std::cout << "TABLE: " << pois().addSchema() << " created ... OK.\n";
-        }
+    try {
+        auto tables = missing({vertices(), ways(), pois(), configuration()});
+        pqxx::work Xaction(connection());
 
-        if (!exists(configuration().addSchema())) {
-            Xaction.exec(configuration().create());
-            std::cout << "TABLE: " << configuration().addSchema() << " created ... OK.\n";
+        for (const auto &table : tables) {
+            Xaction.exec(table.create(m_vm.count("unlogged") != 0));
+            std::cout << "TABLE: " << table.addSchema() << " created ... OK.\n";
         }
 
-
         Xaction.commit();
     } catch (const std::exception &e) {
         std::cerr <<  "\n" << e.what() << std::endl;
@@ -162,27 +223,18 @@ void Export2DB::createTables() const {
 
     if (m_vm.count("addnodes")) {
         try {
-            pqxx::connection db_conn(conninf);
-            pqxx::work Xaction(db_conn);
             /*
              * optional tables
              */
-            if (!exists(osm_nodes().addSchema())) {
-                Xaction.exec(osm_nodes().create());
-                std::cout << "TABLE: " << osm_nodes().addSchema() << " created ... OK.\n";
-            }
+            auto tables = missing({osm_nodes(), osm_ways(), osm_relations()});
+            pqxx::work Xaction(connection());
 
-            if (!exists(osm_ways().addSchema())) {
-                Xaction.exec(osm_ways().create());
-                std::cout << "TABLE: " << osm_ways().addSchema() << " created ... OK.\n";
+            for (const auto &table : tables) {
+                Xaction.exec(table.create(m_vm.count("unlogged") != 0));
+                std::cout << "TABLE: " << table.addSchema() << " created ... OK.\n";
             }
 
-            if (!exists(osm_relations().addSchema())) {
-                Xaction.exec(osm_relations().create());
-                std::cout << "TABLE: " << osm_relations().addSchema() << " created ... OK.\n";
-        }
-
-        Xaction.commit();
+            Xaction.commit();
         } catch (const std::exception &e) {
             std::cerr <<  "\n" << e.what() << std::endl;
             std::cerr <<  "WARNING: could not create osm-*  tables" << std::endl;
@@ -196,8 +248,7 @@ void Export2DB::createTables() const {
 
 void Export2DB::dropTables() const {
     try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
+        pqxx::work Xaction(connection());
 
         Xaction.exec(ways().drop());
         std::cout << "TABLE: " << ways().addSchema() << " dropped ... OK.\n";
@@ -218,8 +269,7 @@ void Export2DB::dropTables() const {
     }
 
     try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
+        pqxx::work Xaction(connection());
         Xaction.exec(osm_nodes().drop());
         std::cout << "TABLE: " << osm_nodes().addSchema() << " dropped ... OK.\n";
 
@@ -241,74 +291,88 @@ Export2DB::export_configuration(const std::map<std::string, Tag_key>& items) con
 
     auto osm_table = m_tables.get_table("configuration");
 
-    std::vector<std::string> values;
+    Copy_writer rows;
 
     for (const auto &item : items) {
-        auto row = item.second.values(osm_table.columns());
-        values.insert(values.end(), row.begin(), row.end());
+        for (const auto &row : item.second.values(osm_table.columns())) {
+            rows.fields(row);
+            rows.end_row();
+        }
+    }
+
+    export_osm(rows.rows(), osm_table);
+}
+
+
+void
+Export2DB::export_osm(
+        Ways::const_iterator begin,
+        Ways::const_iterator end,
+        const Node_store &nodes,
+        const std::string &table) const {
+    auto osm_table = m_tables.get_table(table);
+    const auto &columns = osm_table.columns();
+    Copy_writer rows;
+
+    for (auto it = begin; it != end; ++it) {
+        const auto &way = *it;
+        auto row = way.values(columns, true);
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i] == "the_geom") {
+                row[i] = way.geometry_str(nodes, Way::Split{0, way.nodeRefs().size()});
+            }
+        }
+        rows.fields(row);
+        rows.end_row();
     }
 
-    export_osm(values, osm_table);
+    export_osm(rows.rows(), osm_table);
 }
 
 
 void
 Export2DB::export_osm(
-        const std::vector<std::string> &values,
+        const std::string &rows,
         const Table &table) const {
-    if (values.empty()) return;
+    if (rows.empty()) return;
 
     auto columns = table.columns();
     std::string temp_table(table.temp_name());
     auto create_sql = table.tmp_create();
-    std::string copy_sql( "COPY " + temp_table + " (" + comma_separated(columns) + ") FROM STDIN");
 
 #if 0
     std::cout << "\n" << create_sql;
-    std::cout << "\n" << copy_sql;
 
 #endif
 
-    size_t count = 0;
     try {
 
 
-        pqxx::connection db_con(conninf);
-        pqxx::work Xaction(db_con);
-        PGconn *mycon = PQconnectdb(conninf.c_str());
-
-        PGresult *res = PQexec(mycon, create_sql.c_str());
-        res = PQexec(mycon, copy_sql.c_str());
-        if (res) {};
-
-        for (auto it = values.begin(); it != values.end(); ++it) {
-            auto str = *it;
+        pqxx::work Xaction(connection());
+        auto mycon = copy_connection();
 
-            ++count;
-
-            PQputline(mycon, str.c_str());
-        }
+        begin_copy(mycon, create_sql, temp_table, comma_separated(columns), false);
 
-        PQputline(mycon, "\\.\n");
+        auto copied = Copy_writer::put(mycon, rows);
 
-        if (PQendcopy(mycon) != 0) {
-            Xaction.exec("DROP TABLE " + temp_table);
-            PQfinish(mycon);
+        if (!end_copy(mycon) || !copied) {
+            Xaction.exec("DROP TABLE IF EXISTS " + temp_table);
             Xaction.commit();
 
-            if (values.size() < 2) {
-                for (const auto &v : values) {
-                std::cout << "\n*****ERROR HERE:\n" << v << "\n******";
-                }
+            /*
+             * the rows are escaped: a newline ends a row
+             */
+            auto middle = rows.rfind('\n', rows.size() / 2);
+            if (middle == std::string::npos) middle = rows.find('\n');
+            if (middle + 1 >= rows.size()) {
+                std::cout << "\n*****ERROR HERE:\n" << rows << "******";
                 return;
             }
-            size_t inc = values.size() / 2;
-            export_osm(std::vector<std::string>(values.begin(), values.begin() + inc), table);
-            export_osm(std::vector<std::string>(values.begin() + inc , values.end()), table);
+            export_osm(rows.substr(0, middle + 1), table);
+            export_osm(rows.substr(middle + 1), table);
             return;
         };
 
-        PQfinish(mycon);
         Xaction.exec(m_tables.post_process(table));
         Xaction.exec("DROP TABLE " + temp_table);
         Xaction.commit();
@@ -321,70 +385,230 @@ Export2DB::export_osm(
 
 
 
-/*!
+/*
+ * The vertices of the ways are numbered before the ways are exported:
+ *   - a vertex already in the vertices table keeps its id
+ *   - the new vertices are copied in a single COPY
+ */
+void Export2DB::export_vertices(
+        const Ways &ways,
+        const Node_store &nodes,
+        bool existing_ways,
+        Topology &topology) const {
+    auto threads = m_vm["threads"].as<size_t>();
+    {
+        Thread_pool pool(threads ? threads : std::thread::hardware_concurrency());
+        topology.build(ways, nodes, pool);
+    }
 
-*/
-void Export2DB::fill_vertices_table(
-        const std::string &table,
-        const std::string &vertices_tab,
-        pqxx::work &Xaction) const {
-    // std::cout << "Filling '" << vertices_tab << "' based on '" << table <<"'\n";
-    std::string sql(
-            "WITH osm_vertex AS ("
-            "(SELECT source_osm AS osm_id, x1 AS lon, y1 AS lat FROM " + table + " where source IS NULL)"
-            " union "
-            "(SELECT target_osm AS osm_id, x2 AS lon, y2 AS lat FROM " + table + " where target IS NULL)"
-            ") , "
-            " data1 AS (SELECT osm_id, lon, lat FROM (SELECT DISTINCT * FROM osm_vertex) a "
-            ") "
-            " INSERT INTO " + vertices_tab + " (osm_id, lon, lat, the_geom) (SELECT data1.*, ST_SetSRID(ST_Point(lon, lat), 4326) FROM data1)");
-    auto result = Xaction.exec(sql);
-
-    std::cout << "\t Vertices inserted: " << result.affected_rows();
+    auto table = vertices();
+    auto max_id = get_val("SELECT coalesce(max(id), 0) FROM " + table.addSchema());
+    if (max_id > 0) {
+        try {
+            pqxx::work Xaction(connection());
+            auto result = Xaction.exec("SELECT osm_id, id FROM " + table.addSchema());
+            Xaction.commit();
+            for (const auto &row : result) {
+                topology.existing(row[0].as<int64_t>(), row[1].as<int64_t>(), nodes);
+            }
+        } catch (const std::exception &e) {
+            std::cerr <<  "\n" << e.what() << std::endl;
+            std::cerr << "While reading the vertices of " << table.addSchema() << "\n";
+        }
+    }
+    topology.number(max_id + 1);
+
+    /*
+     * an empty vertices table is truncated in the transaction of the COPY:
+     * the rows can be copied frozen.
+     * A table referencing it (a user table, the ways of a previous run)
+     * can not be truncated with it: the vertices are not frozen
+     */
+    auto freeze = max_id == 0 && !existing_ways && m_vm.count("bulk-load")
+        && get_val(
+                "SELECT CASE WHEN EXISTS (SELECT 1 FROM pg_constraint"
+                " WHERE contype = 'f' AND confrelid = '" + table.addSchema() + "'::regclass)"
+                " THEN 0 ELSE 1 END") == 1;
+
+    PGconn *mycon = nullptr;
+    try {
+        mycon = copy_connection();
+        begin_copy(mycon,
+                freeze ? "TRUNCATE " + table.addSchema() : "",
+                table.addSchema(), "id, osm_id, lon, lat, the_geom", false);
+    } catch (const std::exception &e) {
+        std::cerr <<  "\n" << e.what() << std::endl;
+        std::cerr << "While exporting the vertices to " << table.addSchema() << "\n";
+        return;
+    }
+
+    Copy_writer rows;
+    size_t count = 0;
+    auto ok = true;
+    for (size_t i = 0; ok && i < topology.size(); ++i) {
+        if (!topology.is_new(i)) continue;
+        auto position = topology.position(i);
+        auto lon = nodes.fixed_lon(position);
+        auto lat = nodes.fixed_lat(position);
+        rows.field(topology.vertex_id(i));
+        rows.field(nodes.osm_id(position));
+        rows.coordinate(lon);
+        rows.coordinate(lat);
+        rows.point_geometry(lon, lat);
+        rows.end_row();
+        ++count;
+
+        if (rows.rows().size() >= (size_t(1) << 24)) {
+            ok = Copy_writer::put(mycon, rows.rows());
+            rows.clear();
+        }
+    }
+    if (ok) ok = Copy_writer::put(mycon, rows.rows());
+    ok = end_copy(mycon) && ok;
+    if (!ok) {
+        std::cerr << "While exporting the vertices to " << table.addSchema() << "\n";
+        return;
+    }
+
+    if (count) {
+        execute("SELECT setval(pg_get_serial_sequence('" + table.addSchema() + "', 'id'), "
+                + number_str(max_id + static_cast<int64_t>(count)) + ")");
+    }
+    std::cout << "    Vertices inserted: " << count << "\n";
 }
 
 
 
 
+/*
+ * The COPY rows of the ways [begin, end)
+ *
+ * Writer is a Copy_writer or a Binary_copy_writer
+ *
+ * The document is only read: several batches are serialized concurrently
+ */
+template <typename Writer>
+static
+std::string
+ways_rows(
+        Export2DB::Ways::const_iterator begin,
+        Export2DB::Ways::const_iterator end,
+        const Node_store &nodes,
+        const Configuration &config,
+        const Topology &topology,
+        Writer rows) {
+    std::vector<Way::Split> splits;
+    for (auto it = begin; it != end; ++it) {
+        const auto &way = *it;
+
+        if (way.tag_config().key() == "" || way.tag_config().value() == "") continue;
+
+        way.split_me(nodes, splits);
+        if (splits.empty()) continue;
+
+        /*
+         * the values of a way are written in each row of its splits
+         */
+        auto tag_id = static_cast<int32_t>(config.tag_value(way.tag_config()).id());
+        auto maxspeed_forward = way.maxspeed_forward() == -1 ?
+            config.maxspeed_forward(way.tag_config()) : way.maxspeed_forward();
+        auto maxspeed_backward = way.maxspeed_backward() == -1 ?
+            config.maxspeed_backward(way.tag_config()) : way.maxspeed_backward();
+        auto one_way = static_cast<int32_t>(way.oneWayType());
+        auto priority = config.priority(way.tag_config());
+
+        for (const auto &split : splits) {
+            if (topology.is_duplicate(way, split)) continue;
+
+            auto length = way.length(nodes, split);
+            auto first = way.first_node(split);
+            auto last = way.last_node(split);
+
+            rows.field(tag_id);
+            rows.field(way.osm_id());
+            rows.field(maxspeed_forward);
+            rows.field(maxspeed_backward);
+            rows.field(one_way);
+            rows.field(way.oneWay());
+            rows.field(priority);
+            rows.field(length);
+            rows.coordinate(nodes.fixed_lon(first));
+            rows.coordinate(nodes.fixed_lat(first));
+            rows.coordinate(nodes.fixed_lon(last));
+            rows.coordinate(nodes.fixed_lat(last));
+            rows.field(nodes.osm_id(first));
+            rows.field(nodes.osm_id(last));
+
+            rows.linestring(split.end - split.begin);
+            for (auto i = split.begin; i < split.end; ++i) {
+                auto node = way.nodeRefs()[i];
+                rows.point(nodes.fixed_lon(node), nodes.fixed_lat(node));
+            }
+            rows.end_linestring();
+
+            // cost based on oneway
+            rows.field(way.is_reversed() ? -length : length);
+
+            // reverse_cost
+            rows.field(way.is_oneway() ? -length : length);
+
+            rows.field(way.name());
+            rows.field(topology.id(first));
+            rows.field(topology.id(last));
 
-void Export2DB::fill_source_target(
-        const std::string &table,
-        const std::string &vertices_tab,
-        pqxx::work &Xaction) const {
-    // std::cout << "    Filling 'source' column of '" << table << "':'" << vertices_tab << "'\n";
-    std::string sql1(
-            " UPDATE " + table + " AS w"
-            " SET source = v.id "
-            " FROM " + vertices_tab + " AS v"
-            " WHERE w.source IS NULL and w.source_osm = v.osm_id;");
-    Xaction.exec(sql1);
-
-    std::string sql2(
-            " UPDATE " + table + " AS w"
-            " SET target = v.id "
-            " FROM " + vertices_tab + " AS v"
-            " WHERE w.target IS NULL and w.target_osm = v.osm_id;");
-    Xaction.exec(sql2);
-
-    std::string sql3(
-            " UPDATE " + table +
-            " SET  length_m = ST_length(geography(ST_Transform(the_geom, 4326))),"
-            "      cost_s = CASE "
-            "           WHEN one_way = -1 THEN -ST_length(geography(ST_Transform(the_geom, 4326))) / (maxspeed_forward::float * 5.0 / 18.0)"
-            "           ELSE ST_length(geography(ST_Transform(the_geom, 4326))) / (maxspeed_backward::float * 5.0 / 18.0)"
-            "             END, "
-            "      reverse_cost_s = CASE "
-            "           WHEN one_way = 1 THEN -ST_length(geography(ST_Transform(the_geom, 4326))) / (maxspeed_backward::float * 5.0 / 18.0)"
-            "           ELSE ST_length(geography(ST_Transform(the_geom, 4326))) / (maxspeed_backward::float * 5.0 / 18.0)"
-            "             END "
-            " WHERE length_m IS NULL AND maxspeed_backward !=0 AND maxspeed_forward != 0;");
-    Xaction.exec(sql3);
+            /*
+             * length_m & the costs in seconds are left NULL without speeds
+             * cost_s uses maxspeed_backward unless the way is reversed
+             */
+            if (maxspeed_forward != 0 && maxspeed_backward != 0) {
+                auto length_m = way.length_m(nodes, split);
+                auto forward = maxspeed_forward * 5.0 / 18.0;
+                auto backward = maxspeed_backward * 5.0 / 18.0;
+                rows.field(length_m);
+                rows.field(one_way == -1 ? -length_m / forward : length_m / backward);
+                rows.field(one_way == 1 ? -length_m / backward : length_m / backward);
+            } else {
+                rows.field(std::string());
+                rows.field(std::string());
+                rows.field(std::string());
+            }
+            rows.end_row();
+        }
+    }
+    return rows.take();
 }
 
 
+/*
+ * Pipeline:
+ *   - the ways of the chunks are split & serialized on the worker threads,
+ *     each chunk in as many batches as there are threads
+ *   - the main thread COPYs the batches in order & processes the chunk
+ *   - at most two chunks are waiting to be copied
+ *
+ * The rows reach the database in the same order for any number of threads.
+ */
+void Export2DB::exportWays(
+        const Ways &ways,
+        const Node_store &nodes,
+        const Configuration &config) const {
+    /*
+     * the ways of a previous import can be duplicated by the new ways
+     */
+    auto existing_ways = get_val("SELECT count(*) FROM (SELECT 1 FROM " + this->ways().addSchema() + " LIMIT 1) AS w") != 0;
 
+    Topology topology;
+    export_vertices(ways, nodes, existing_ways, topology);
+    if (topology.duplicates()) {
+        std::cout << "    Duplicated split ways skipped: " << topology.duplicates() << "\n";
+    }
+
+    auto connections = m_vm["connections"].as<size_t>();
+    if (connections > 1) {
+        export_ways_concurrently(ways, nodes, config, topology, existing_ways, connections);
+        return;
+    }
 
-void Export2DB::exportWays(const Ways &ways, const Configuration &config) const {
     std::cout << "    Processing " <<  ways.size() <<  " ways"  << ":\n";
 
     Table table = this->ways();
@@ -397,128 +621,191 @@ void Export2DB::exportWays(const Ways &ways, const Configuration &config) const
     auto create_sql = table.tmp_create();
     auto temp_table(table.temp_name());
 
-    std::string copy_sql( "COPY " + temp_table + " (" + comma_separated(columns) + ") FROM STDIN");
+    auto binary = m_vm.count("binary-copy") != 0;
+
+    auto threads = m_vm["threads"].as<size_t>();
+    Thread_pool pool(threads ? threads : std::thread::hardware_concurrency());
+
+    struct Chunk {
+        size_t start;
+        size_t limit;
+        std::vector<std::future<std::string>> batches;
+    };
+    std::deque<Chunk> pending;
+
+    size_t next = 0;
+    while (next < ways.size() || !pending.empty()) {
+        while (next < ways.size() && pending.size() < 2) {
+            Chunk chunk;
+            chunk.start = next;
+            chunk.limit = (next + chunck_size) < ways.size() ? next + chunck_size : ways.size();
+            auto batch_size = (chunk.limit - chunk.start + pool.size() - 1) / pool.size();
+            for (auto i = chunk.start; i < chunk.limit; i += batch_size) {
+                auto begin = ways.begin() + static_cast<ptrdiff_t>(i);
+                auto end = ways.begin() + static_cast<ptrdiff_t>(std::min(i + batch_size, chunk.limit));
+                auto fields = columns.size();
+                chunk.batches.push_back(pool.submit([begin, end, &nodes, &config, &topology, binary, fields] {
+                            return binary ?
+                                ways_rows(begin, end, nodes, config, topology, Binary_copy_writer(fields))
+                                : ways_rows(begin, end, nodes, config, topology, Copy_writer());
+                            }));
+            }
+            next = chunk.limit;
+            pending.push_back(std::move(chunk));
+        }
 
+        auto chunk = std::move(pending.front());
+        pending.pop_front();
+        auto start = chunk.start;
+        auto limit = chunk.limit;
+        try {
+            pqxx::work Xaction(connection());
 
-    int64_t split_count = 0;
-    int64_t count = 0;
-    size_t start = 0;
-    auto it = ways.begin();
+            auto mycon = copy_connection();
+            begin_copy(mycon, create_sql, temp_table, ways_columns, binary);
 
-    while (start < ways.size()) {
-        auto limit = (start + chunck_size) < ways.size() ? start + chunck_size : ways.size();
-        try {
-            pqxx::connection db_con(conninf);
-            pqxx::work Xaction(db_con);
-
-            PGconn *mycon = PQconnectdb(conninf.c_str());
-            PGresult *res = PQexec(mycon, create_sql.c_str());
-            res = PQexec(mycon, copy_sql.c_str());
-            if (res) {};
-
-
-            for (auto i = start; i < limit; ++i) {
-                auto way = *it;
-
-                ++count;
-                ++it;
-
-                if (way.tag_config().key() == "" || way.tag_config().value() == "") continue;
-
-                std::vector<std::string> common_values;
-                common_values.push_back(TO_STR(config.tag_value(way.tag_config()).id()));
-                common_values.push_back(TO_STR(way.osm_id()));
-                common_values.push_back(way.maxspeed_forward_str() == "-1" ? TO_STR(config.maxspeed_forward(way.tag_config())) : way.maxspeed_forward_str()) ;
-                common_values.push_back(way.maxspeed_backward_str() == "-1" ? TO_STR(config.maxspeed_backward(way.tag_config())) : way.maxspeed_backward_str()) ;
-                common_values.push_back(way.oneWayType_str());
-                common_values.push_back(way.oneWay());
-                // common_values.push_back(way.has_attribute("oneway") ? way.get_attribute("oneway") : std::string(""));
-                common_values.push_back(TO_STR(config.priority(way.tag_config())));
-
-                auto splits = way.split_me();
-                split_count +=  splits.size();
-                for (size_t j = 0; j < splits.size(); ++j) {
-                    auto length = way.length_str(splits[j]);
-
-                    auto values = common_values;
-                    values.push_back(length);
-                    values.push_back(splits[j].front()->lon());
-                    values.push_back(splits[j].front()->lat());
-                    values.push_back(splits[j].back()->lon());
-                    values.push_back(splits[j].back()->lat());
-                    values.push_back(TO_STR(splits[j].front()->osm_id()));
-                    values.push_back(TO_STR(splits[j].back()->osm_id()));
-                    values.push_back(way.geometry_str(splits[j]));
-
-                    // cost based on oneway
-                    if (way.is_reversed())
-                        values.push_back(std::string("-") + length);
-                    else
-                        values.push_back(length);
-
-                    // reverse_cost
-                    if (way.is_oneway())
-                        values.push_back(std::string("-") + length);
-                    else
-                        values.push_back(length);
-
-                    values.push_back(way.name());
-                    PQputline(mycon, tab_separated(values).c_str());
-                }
+            auto ok = !binary || Copy_writer::put(mycon, Binary_copy_writer::header());
+            for (auto &batch : chunk.batches) {
+                ok = ok && Copy_writer::put(mycon, batch.get());
             }
+            if (ok && binary) ok = Copy_writer::put(mycon, Binary_copy_writer::trailer());
+            ok = end_copy(mycon) && ok;
 
-            PQputline(mycon, "\\.\n");
-            PQendcopy(mycon);
-
-            print_progress(ways.size(), count);
-            process_section(ways_columns, Xaction);
-            Xaction.exec("DROP TABLE " + temp_table);
+            print_progress(ways.size(), limit);
+            if (ok) {
+                process_section(temp_table, ways_columns, existing_ways, Xaction);
+            } else {
+                std::cerr << "\nThe ways FROM " << start << "th \t to: " << limit << "th way were not copied\n";
+            }
+            Xaction.exec("DROP TABLE IF EXISTS " + temp_table);
             Xaction.commit();
         } catch (const std::exception &e) {
             std::cerr <<  "\n" << e.what() << std::endl;
             std::cerr << "While processing FROM " << start << "th \t to: " << limit << "th way\n";
-            std::cerr << "count" << count << " While processing FROM " << start << "th \t to: " << limit << "th way\n";
         }
-
-        start = limit;
     }
 }
 
 
 
-void Export2DB::process_section(const std::string &ways_columns, pqxx::work &Xaction) const {
-    //  std::cout << "Creating indices in temporary table\n";
-    auto temp_table(ways().temp_name());
-
-    Xaction.exec("CREATE INDEX "+ temp_table + "_gdx ON "+ temp_table + " using gist(the_geom);");
-    Xaction.exec("CREATE INDEX ON "+ temp_table + "  USING btree (source_osm)");
-    Xaction.exec("CREATE INDEX ON "+ temp_table + "  USING btree (target_osm)");
+/*
+ * Each connection:
+ *   - serializes its chunks: worker, worker + connections, ...
+ *   - COPYs them into its staging table in a single COPY
+ *
+ * The staging tables are then processed one after the other,
+ * each as one large section.
+ */
+void Export2DB::export_ways_concurrently(
+        const Ways &ways,
+        const Node_store &nodes,
+        const Configuration &config,
+        const Topology &topology,
+        bool existing_ways,
+        size_t connections) const {
+    Table table = this->ways();
 
+    auto columns = table.columns();
+    auto ways_columns = comma_separated(columns);
+    auto fields = columns.size();
 
+    size_t chunck_size = m_vm["chunk"].as<size_t>();
+    auto chunks = (ways.size() + chunck_size - 1) / chunck_size;
+    connections = std::max(static_cast<size_t>(1), std::min(connections, chunks));
+
+    auto binary = m_vm.count("binary-copy") != 0;
+
+    std::cout << "    Processing " <<  ways.size() <<  " ways on " << connections << " connections:\n";
+
+    std::atomic<size_t> copied(0);
+    std::mutex progress_mutex;
+
+    std::vector<std::string> staging;
+    std::vector<std::future<bool>> workers;
+    Thread_pool pool(connections);
+    for (size_t worker = 0; worker < connections; ++worker) {
+        staging.push_back(table.temp_name() + "_" + number_str(worker));
+        auto name = staging.back();
+        workers.push_back(pool.submit([&, worker, name] {
+                    auto conn = PQconnectdb(conninf.c_str());
+                    if (PQstatus(conn) != CONNECTION_OK) {
+                        std::cerr << PQerrorMessage(conn);
+                        PQfinish(conn);
+                        return false;
+                    }
+                    try {
+                        begin_copy(conn, table.tmp_create(name), name, ways_columns, binary);
+                    } catch (const std::exception &e) {
+                        std::lock_guard<std::mutex> lock(progress_mutex);
+                        std::cerr <<  "\n" << e.what() << std::endl;
+                        PQfinish(conn);
+                        return false;
+                    }
+
+                    auto ok = !binary || Copy_writer::put(conn, Binary_copy_writer::header());
+                    for (auto start = worker * chunck_size;
+                            ok && start < ways.size();
+                            start += connections * chunck_size) {
+                        auto begin = ways.begin() + static_cast<ptrdiff_t>(start);
+                        auto end = ways.begin() + static_cast<ptrdiff_t>(std::min(start + chunck_size, ways.size()));
+                        ok = Copy_writer::put(conn, binary ?
+                                ways_rows(begin, end, nodes, config, topology, Binary_copy_writer(fields))
+                                : ways_rows(begin, end, nodes, config, topology, Copy_writer()));
+
+                        auto done = copied += static_cast<size_t>(end - begin);
+                        std::lock_guard<std::mutex> lock(progress_mutex);
+                        print_progress(ways.size(), done);
+                    }
+                    if (ok && binary) ok = Copy_writer::put(conn, Binary_copy_writer::trailer());
+                    ok = end_copy(conn) && ok;
+                    PQfinish(conn);
+                    return ok;
+                    }));
+    }
 
+    std::vector<bool> copied_ok;
+    for (auto &worker : workers) copied_ok.push_back(worker.get());
 
-    //  std::cout << "Deleting  duplicated ways FROM temporary table\n";
-    std::string delete_from_temp(
-            " DELETE FROM "+ temp_table + " a "
-            "     USING " + ways().addSchema() + " b "
-            "     WHERE a.the_geom ~= b.the_geom AND ST_OrderingEquals(a.the_geom, b.the_geom);");
-    Xaction.exec(delete_from_temp);
+    std::cout << "\n    Merging " << staging.size() << " staging tables:\n";
+    for (size_t i = 0; i < staging.size(); ++i) {
+        try {
+            pqxx::work Xaction(connection());
+            if (copied_ok[i]) {
+                process_section(staging[i], ways_columns, existing_ways, Xaction);
+            } else {
+                std::cerr << "The rows of " << staging[i] << " were not copied\n";
+            }
+            Xaction.exec("DROP TABLE IF EXISTS " + staging[i]);
+            Xaction.commit();
+        } catch (const std::exception &e) {
+            std::cerr <<  "\n" << e.what() << std::endl;
+            std::cerr << "While merging " << staging[i] << "\n";
+        }
+    }
+}
 
-    //  std::cout << "Updating to existing toplology the temporary table\n";
-    fill_source_target(temp_table, vertices().addSchema(), Xaction);
 
-    //  std::cout << "Inserting new vertices in the vertex table\n";
-    fill_vertices_table(temp_table, vertices().addSchema(), Xaction);
 
-    //  std::cout << "Updating to new toplology the temporary table\n";
-    fill_source_target(temp_table, vertices().addSchema(), Xaction);
+void Export2DB::process_section(
+        const std::string &temp_table,
+        const std::string &ways_columns,
+        bool existing_ways,
+        pqxx::work &Xaction) const {
+    if (existing_ways) {
+        //  std::cout << "Deleting  duplicated ways FROM temporary table\n";
+        std::string delete_from_temp(
+                " DELETE FROM "+ temp_table + " a "
+                "     USING " + ways().addSchema() + " b "
+                "     WHERE a.the_geom ~= b.the_geom AND ST_OrderingEquals(a.the_geom, b.the_geom);");
+        Xaction.exec(delete_from_temp);
+    }
 
 
     //  std::cout << "Inserting new split ways to '" << addSchema(full_table_name("ways")) << "'\n";
     std::string insert_into_ways(
             " INSERT INTO " + ways().addSchema() +
-            "(" + ways_columns + ", source, target, length_m, cost_s, reverse_cost_s) "
-            " (SELECT " + ways_columns + ", source, target, length_m, cost_s, reverse_cost_s FROM " + temp_table + "); ");
+            "(" + ways_columns + ") "
+            " (SELECT " + ways_columns + " FROM " + temp_table + "); ");
     auto result = Xaction.exec(insert_into_ways);
     std::cout << "\tSplit ways inserted " << result.affected_rows() << "\n";
 }
@@ -533,8 +820,7 @@ Export2DB::get_val(const std::string sql) const {
     std::cout << "\nExecuting: \n" << sql << "\n";
 #endif
     try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
+        pqxx::work Xaction(connection());
         auto result = Xaction.exec(sql);
         Xaction.commit();
         if (result.size() == 0) return 0;
@@ -552,8 +838,7 @@ Export2DB::execute(const std::string sql) const {
     std::cout << "\nExecuting: \n" << sql << "\n";
 #endif
     try {
-        pqxx::connection db_conn(conninf);
-        pqxx::work Xaction(db_conn);
+        pqxx::work Xaction(connection());
         Xaction.exec(sql);
         Xaction.commit();
     } catch (const std::exception &e) {
@@ -575,35 +860,125 @@ Export2DB::execute(const std::string sql) const {
  */
 void Export2DB::createFKeys() const {
     /*
-     * configuration:
+     * 1: the indexes
+     * CREATE INDEX only locks out the writes:
+     * the indexes of a table are built concurrently too
      */
-    execute(configuration().primary_key("id"));
-    execute(configuration().unique("tag_id"));
+    execute_concurrently({
+            {configuration().key_index("id", true)},
+            {configuration().key_index("tag_id", false)},
+            {vertices().key_index("id", true)},
+            {vertices().key_index("osm_id", false)},
+            {vertices().gist_index()},
+            {ways().key_index("gid", true)},
+            {ways().gist_index()},
+            {pois().key_index("pid", true)},
+            {pois().key_index("osm_id", false)},
+            {pois().gist_index()}});
 
     /*
-     * vertices
+     * 2: the keys on those indexes
+     * ALTER TABLE locks the table: one session per table
      */
-    execute(vertices().primary_key("id"));
-    execute(vertices().unique("osm_id"));
-    execute(vertices().gist_index());
+    execute_concurrently({
+            {configuration().primary_key(), configuration().unique("tag_id")},
+            {vertices().primary_key(), vertices().unique("osm_id")},
+            {ways().primary_key()},
+            {pois().primary_key(), pois().unique("osm_id")}});
 
     /*
-     * Ways
+     * 3: the foreign keys of ways, once the keys they reference exist
+     * they lock ways: they are added one after the other
      */
-    execute(ways().primary_key("gid"));
-    execute(ways().foreign_key("source", vertices(), "id"));
-    execute(ways().foreign_key("target", vertices(), "id"));
-    execute(ways().foreign_key("source_osm", vertices(), "osm_id"));
-    execute(ways().foreign_key("target_osm", vertices(), "osm_id"));
-    execute(ways().foreign_key("tag_id", configuration(), "tag_id"));
-    execute(ways().gist_index());
+    execute_concurrently({{
+        ways().foreign_key("source", vertices(), "id"),
+        ways().foreign_key("target", vertices(), "id"),
+        ways().foreign_key("source_osm", vertices(), "osm_id"),
+        ways().foreign_key("target_osm", vertices(), "osm_id"),
+        ways().foreign_key("tag_id", configuration(), "tag_id")}});
+}
 
-    /*
-     * ponitsOfInterest
-     */
-    execute(pois().primary_key("pid"));
-    execute(pois().gist_index());
-    execute(pois().unique("osm_id"));
+
+/*
+ * Each job is a list of statements run in order in one session,
+ * the jobs are taken by the first idle session
+ */
+void Export2DB::execute_concurrently(const std::vector<std::vector<std::string>> &jobs) const {
+    auto sessions = std::min(jobs.size(), m_vm["index-connections"].as<size_t>());
+    if (sessions <= 1) {
+        for (const auto &job : jobs) {
+            for (const auto &sql : job) execute(sql);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::mutex output_mutex;
+    auto warning = [&output_mutex](const std::string &what, const std::string &sql) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << "\nWARNING: " << what << std::endl;
+        std::cout <<  sql << "\n";
+    };
+
+    Thread_pool pool(sessions);
+    std::vector<std::future<void>> workers;
+    for (size_t i = 0; i < sessions; ++i) {
+        workers.push_back(pool.submit([&] {
+                    std::unique_ptr<pqxx::connection> session;
+                    try {
+                        session.reset(new pqxx::connection(conninf));
+                    } catch (const std::exception &e) {
+                        /*
+                         * the jobs are left to the other sessions
+                         */
+                        warning(e.what(), "");
+                        return;
+                    }
+                    for (auto job = next++; job < jobs.size(); job = next++) {
+                        for (const auto &sql : jobs[job]) {
+                            try {
+                                pqxx::work Xaction(*session);
+                                Xaction.exec(sql);
+                                Xaction.commit();
+                            } catch (const std::exception &e) {
+                                warning(e.what(), sql);
+                            }
+                        }
+                    }
+                    }));
+    }
+    for (auto &worker : workers) worker.get();
+}
+
+
+/*
+ * End of the import:
+ *   - the tables created UNLOGGED are written to the WAL (SET LOGGED),
+ *     a table before the tables that reference it
+ *   - with --bulk-load the autovacuum is enabled again & the tables are analyzed
+ */
+void Export2DB::finish_load() const {
+    auto unlogged = m_vm.count("unlogged") != 0;
+    auto bulk_load = m_vm.count("bulk-load") != 0;
+    if (!unlogged && !bulk_load) return;
+
+    std::vector<Table> tables{configuration(), vertices(), ways(), pois()};
+    if (m_vm.count("addnodes")) {
+        tables.push_back(osm_nodes());
+        tables.push_back(osm_ways());
+        tables.push_back(osm_relations());
+    }
+
+    for (const auto &table : tables) {
+        if (unlogged) {
+            execute("ALTER TABLE " + table.addSchema() + " SET LOGGED");
+        }
+        if (bulk_load) {
+            execute("ALTER TABLE " + table.addSchema() + " SET (autovacuum_enabled = true)");
+            execute("ANALYZE " + table.addSchema());
+        }
+        std::cout << "TABLE: " << table.addSchema() << " finished ... OK.\n";
+    }
 }
 
 
@@ -0,0 +1,160 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+#include "database/binary_copy_writer.h"
+
+#include <cstring>
+#include <string>
+
+namespace osm2pgr {
+
+namespace {
+
+/*
+ * the fields are in network byte order (big endian)
+ */
+void
+put_be(std::string &rows, uint64_t value, int bytes) {
+    for (int shift = 8 * (bytes - 1); shift >= 0; shift -= 8) {
+        rows += static_cast<char>((value >> shift) & 0xff);
+    }
+}
+
+
+/*
+ * the EWKB of a geometry is written little endian (NDR)
+ */
+void
+put_le(std::string &rows, uint64_t value, int bytes) {
+    for (int shift = 0; shift < 8 * bytes; shift += 8) {
+        rows += static_cast<char>((value >> shift) & 0xff);
+    }
+}
+
+
+uint64_t
+bits(double value) {
+    uint64_t result;
+    memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+
+double
+degrees(int32_t value) {
+    return static_cast<double>(value) / 10000000.0;
+}
+
+
+const uint32_t EWKB_LINESTRING = 2;
+const uint32_t EWKB_SRID_FLAG = 0x20000000;
+const uint32_t SRID = 4326;
+
+}  // namespace
+
+
+void
+Binary_copy_writer::start_field() {
+    if (!m_row_start) return;
+    put_be(m_rows, static_cast<uint16_t>(m_fields), 2);
+    m_row_start = false;
+}
+
+
+void
+Binary_copy_writer::field(const char *value, size_t size) {
+    start_field();
+    if (size == 0) {
+        put_be(m_rows, static_cast<uint32_t>(-1), 4);
+        return;
+    }
+    put_be(m_rows, size, 4);
+    m_rows.append(value, size);
+}
+
+
+void
+Binary_copy_writer::field(int32_t value) {
+    start_field();
+    put_be(m_rows, 4, 4);
+    put_be(m_rows, static_cast<uint32_t>(value), 4);
+}
+
+
+void
+Binary_copy_writer::field(int64_t value) {
+    start_field();
+    put_be(m_rows, 8, 4);
+    put_be(m_rows, static_cast<uint64_t>(value), 8);
+}
+
+
+void
+Binary_copy_writer::field(double value) {
+    start_field();
+    put_be(m_rows, 8, 4);
+    put_be(m_rows, bits(value), 8);
+}
+
+
+void
+Binary_copy_writer::coordinate(int32_t value) {
+    field(degrees(value));
+}
+
+
+void
+Binary_copy_writer::linestring(size_t points) {
+    start_field();
+    /*
+     * byte order, type, srid, number of points, points
+     */
+    put_be(m_rows, 1 + 4 + 4 + 4 + 16 * points, 4);
+    m_rows += '\1';
+    put_le(m_rows, EWKB_LINESTRING | EWKB_SRID_FLAG, 4);
+    put_le(m_rows, SRID, 4);
+    put_le(m_rows, points, 4);
+}
+
+
+void
+Binary_copy_writer::point(int32_t lon, int32_t lat) {
+    put_le(m_rows, bits(degrees(lon)), 8);
+    put_le(m_rows, bits(degrees(lat)), 8);
+}
+
+
+std::string
+Binary_copy_writer::header() {
+    std::string header("PGCOPY\n\377\r\n\0", 11);
+    put_be(header, 0, 4);
+    put_be(header, 0, 4);
+    return header;
+}
+
+
+std::string
+Binary_copy_writer::trailer() {
+    std::string trailer;
+    put_be(trailer, static_cast<uint16_t>(-1), 2);
+    return trailer;
+}
+
+}  // end namespace osm2pgr
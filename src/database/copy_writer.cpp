@@ -0,0 +1,197 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+#include "database/copy_writer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "utilities/number_format.h"
+
+namespace osm2pgr {
+
+namespace {
+
+const size_t BLOCK_SIZE = 1024 * 1024;
+
+}  // namespace
+
+
+void
+Copy_writer::field(const char *value, size_t size) {
+    separator();
+
+    if (size == 0) {
+        m_rows += "\\N";
+        return;
+    }
+
+    auto end = value + size;
+    while (value < end) {
+        /*
+         * the characters that do not need escaping are copied at once
+         */
+        auto special = std::find_if(value, end, [](char c) {
+                return c == '\\' || c == '\t' || c == '\n' || c == '\r';
+                });
+        m_rows.append(value, static_cast<size_t>(special - value));
+        if (special == end) break;
+
+        switch (*special) {
+            case '\\': m_rows += "\\\\"; break;
+            case '\t': m_rows += "\\t"; break;
+            case '\n': m_rows += "\\n"; break;
+            default: m_rows += "\\r"; break;
+        }
+        value = special + 1;
+    }
+}
+
+
+/*
+ * the numbers are written directly in the buffer: they need no escaping
+ */
+void
+Copy_writer::field(int32_t value) {
+    field(static_cast<int64_t>(value));
+}
+
+
+void
+Copy_writer::field(int64_t value) {
+    separator();
+    char buffer[NUMBER_SIZE];
+    m_rows.append(buffer, format_int(value, buffer));
+}
+
+
+void
+Copy_writer::field(double value) {
+    separator();
+    char buffer[NUMBER_SIZE];
+    m_rows.append(buffer, format_double(value, buffer));
+}
+
+
+void
+Copy_writer::coordinate(int32_t value) {
+    separator();
+    char buffer[NUMBER_SIZE];
+    m_rows.append(buffer, format_fixed(value, 7, buffer));
+}
+
+
+void
+Copy_writer::linestring(size_t points) {
+    separator();
+    m_rows += points ? "srid=4326;LINESTRING(" : "srid=4326;LINESTRING EMPTY";
+    m_points = 0;
+}
+
+
+void
+Copy_writer::point(int32_t lon, int32_t lat) {
+    if (m_points++) m_rows += ", ";
+    char buffer[NUMBER_SIZE];
+    m_rows.append(buffer, format_fixed(lon, 7, buffer));
+    m_rows += ' ';
+    m_rows.append(buffer, format_fixed(lat, 7, buffer));
+}
+
+
+void
+Copy_writer::end_linestring() {
+    if (m_points) m_rows += ')';
+}
+
+
+void
+Copy_writer::point_geometry(int32_t lon, int32_t lat) {
+    separator();
+    m_rows += "srid=4326;POINT(";
+    m_points = 0;
+    point(lon, lat);
+    m_rows += ')';
+}
+
+
+/*
+ * PQexec returns the result of the last statement of @b sql:
+ * a prepare ending with a SELECT returns PGRES_TUPLES_OK
+ */
+void
+Copy_writer::begin(
+        PGconn *conn,
+        const std::string &prepare,
+        const std::string &copy_sql) {
+    auto exec = [conn](const std::string &sql, bool copy) {
+        auto result = PQexec(conn, sql.c_str());
+        auto status = PQresultStatus(result);
+        PQclear(result);
+        if (copy ? status == PGRES_COPY_IN
+                : status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK) {
+            return;
+        }
+
+        std::string error(PQerrorMessage(conn));
+        PQclear(PQexec(conn, "ROLLBACK"));
+        throw std::runtime_error(error + "While executing: " + sql);
+    };
+
+    exec("BEGIN", false);
+    if (prepare != "") exec(prepare, false);
+    exec(copy_sql, true);
+}
+
+
+bool
+Copy_writer::put(PGconn *conn, const char *rows, size_t size) {
+    for (size_t sent = 0; sent < size; sent += BLOCK_SIZE) {
+        auto block = static_cast<int>(std::min(BLOCK_SIZE, size - sent));
+        if (PQputCopyData(conn, rows + sent, block) != 1) {
+            std::cerr << PQerrorMessage(conn);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool
+Copy_writer::end(PGconn *conn) {
+    if (PQputCopyEnd(conn, nullptr) != 1) {
+        std::cerr << PQerrorMessage(conn);
+        return false;
+    }
+
+    bool ok = true;
+    while (auto result = PQgetResult(conn)) {
+        if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+            std::cerr << PQresultErrorMessage(result);
+            ok = false;
+        }
+        PQclear(result);
+    }
+    return ok;
+}
+
+}  // end namespace osm2pgr
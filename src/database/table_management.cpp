@@ -51,28 +51,41 @@ Table::gist_index() const {
 }
 
 
+/*
+ * the names postgreSQL gives to the constraints
+ */
 std::string
-Table::foreign_key(
-        const std::string &column,
-        const Table &table,
-        const std::string &table_column) const {
-    return "ALTER TABLE " + addSchema()
-        + "\n  ADD FOREIGN KEY (" + column + ")"
-        + "\n  REFERENCES " + table.addSchema() + "(" + table_column + ")"
-        + "\n  ON UPDATE NO ACTION \n  ON DELETE NO ACTION;";
+Table::key_index(const std::string &column, bool primary) const {
+    return "CREATE UNIQUE INDEX "
+        + table_name() + (primary ? "_pkey" : "_" + column + "_key")
+        + " ON " + addSchema() + " (" + column + ")";
 }
 
 
 std::string
-Table::unique(const std::string &column) const {
+Table::primary_key() const {
     return std::string("ALTER TABLE " + addSchema()
-        + "\n  ADD UNIQUE (" + column + ")");
+        + "\n  ADD PRIMARY KEY USING INDEX " + table_name() + "_pkey");
 }
 
+
 std::string
-Table::primary_key(const std::string &column) const {
+Table::unique(const std::string &column) const {
     return std::string("ALTER TABLE " + addSchema()
-        + "\n  ADD PRIMARY KEY (" + column + ")");
+        + "\n  ADD UNIQUE USING INDEX " + table_name() + "_" + column + "_key");
+}
+
+
+std::string
+Table::foreign_key(
+        const std::string &column,
+        const Table &table,
+        const std::string &table_column) const {
+    return "ALTER TABLE " + addSchema()
+        + "\n  ADD CONSTRAINT " + table_name() + "_" + column + "_fkey"
+        + " FOREIGN KEY (" + column + ")"
+        + "\n  REFERENCES " + table.addSchema() + "(" + table_column + ")"
+        + "\n  ON UPDATE NO ACTION \n  ON DELETE NO ACTION;";
 }
 
 
@@ -97,9 +110,9 @@ Table::addSchema() const {
  */
 
 std::string
-Table::create() const {
+Table::create(bool unlogged) const {
     std::string sql =
-        "CREATE TABLE " + addSchema() + " ("
+        std::string(unlogged ? "CREATE UNLOGGED TABLE " : "CREATE TABLE ") + addSchema() + " ("
         + m_create
         + m_other_columns
         + m_constraint + ")";
@@ -142,16 +155,22 @@ Table::temp_name() const {
 
 std::string
 Table::tmp_create() const {
+    return tmp_create(temp_name());
+}
+
+
+std::string
+Table::tmp_create(const std::string &name) const {
     std::string sql =
         "CREATE UNLOGGED TABLE " 
-        + temp_name()
+        + name
         + " ("
         + m_create
         + m_other_columns
         + ");";
     if (m_geometry != "") {
         sql += "SELECT AddGeometryColumn('"
-            + temp_name() + "', 'the_geom', 4326, '" + m_geometry + "', 2);";
+            + name + "', 'the_geom', 4326, '" + m_geometry + "', 2);";
     }
     return sql;
 }
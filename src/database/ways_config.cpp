@@ -110,6 +110,11 @@ Tables::ways_config() const {
     columns.push_back("cost");
     columns.push_back("reverse_cost");
     columns.push_back("name");
+    columns.push_back("source");
+    columns.push_back("target");
+    columns.push_back("length_m");
+    columns.push_back("cost_s");
+    columns.push_back("reverse_cost_s");
 
 
 #if 0
@@ -19,15 +19,11 @@
  ***************************************************************************/
 
 
-#if 0
-#include <boost/geometry.hpp>
-#include <boost/geometry/geometries/point_xy.hpp>
-#endif
-
 #include <boost/lexical_cast.hpp>
 #include <map>
 #include <cassert>
 #include <math.h>
+#include <string>
 #include "osm_elements/osm_tag.h"
 #include "osm_elements/Node.h"
 
@@ -49,29 +45,42 @@ Node::tag_config(const Tag &tag) {
 }
 
 
-double
-Node::getLength(const Node &previous) const {
-    auto y1 = boost::lexical_cast<double>(get_attribute("lat"));
-    auto x1 = boost::lexical_cast<double>(get_attribute("lon"));
-    auto y2 = boost::lexical_cast<double>(previous.get_attribute("lat"));
-    auto x2 = boost::lexical_cast<double>(previous.get_attribute("lon"));
-    return sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
-#if 0
-    typedef boost::geometry::model::d2::point_xy<double> point_type;
-
-    /* converted point to fit boost.geomtery
-     *      * (`p` and `q` are same as `a ` and `b`)
-     *           */
-    point_type p(
-            boost::lexical_cast<double>(get_attribute("lat")),
-            boost::lexical_cast<double>(get_attribute("lon")));
-
-    point_type q(
-            boost::lexical_cast<double>(previous.get_attribute("lat")),
-            boost::lexical_cast<double>(previous.get_attribute("lon")));
-
-    return boost::geometry::distance(p, q);
-#endif
+int32_t
+Node::fixed_point(const std::string &coordinate) {
+    auto p = coordinate.c_str();
+    auto negative = *p == '-';
+    if (*p == '-' || *p == '+') ++p;
+
+    int64_t value = 0;
+    for (; *p >= '0' && *p <= '9'; ++p) value = value * 10 + (*p - '0');
+
+    int decimals = 0;
+    if (*p == '.') {
+        for (++p; *p >= '0' && *p <= '9' && decimals < 7; ++p, ++decimals) {
+            value = value * 10 + (*p - '0');
+        }
+        /*
+         * rounding to the 7th decimal
+         */
+        if (decimals == 7 && *p >= '5' && *p <= '9') ++value;
+        while (*p >= '0' && *p <= '9') ++p;
+    }
+    for (; decimals < 7; ++decimals) value *= 10;
+
+    if (*p != '\0') {
+        /*
+         * not a plain decimal number (an exponent)
+         */
+        return static_cast<int32_t>(llround(boost::lexical_cast<double>(coordinate) * 1e7));
+    }
+    return static_cast<int32_t>(negative ? -value : value);
+}
+
+
+std::string
+Node::coordinate_str(int32_t coordinate) {
+    char buffer[NUMBER_SIZE];
+    return std::string(buffer, format_fixed(coordinate, 7, buffer));
 }
 
 
@@ -20,7 +20,9 @@
 
 #include "osm_elements/OSMDocument.h"
 
-#include <boost/lexical_cast.hpp>
+#include <boost/iterator/filter_iterator.hpp>
+#include <string.h>
+#include <cstdlib>
 #include <vector>
 #include <map>
 #include <utility>
@@ -44,8 +46,7 @@ namespace osm2pgr {
 OSMDocument::OSMDocument(
         const Configuration &config,
         const po::variables_map &vm,
-        const Export2DB &db_conn,
-        size_t lines) :
+        const Export2DB &db_conn) :
     m_relPending(false),
     m_waysPending(true),
     m_rConfig(config),
@@ -53,7 +54,17 @@ OSMDocument::OSMDocument(
     m_db_conn(db_conn),
     m_chunk_size(vm["chunk"].as<size_t>()),
     m_nodeErrs(0),
-    m_lines(lines) {
+    m_keep_only(false) {
+        m_nodes.use_rank_index(vm.count("rank-index") != 0);
+        m_nodes.dense(vm["nodes-layout"].as<std::string>() == "dense");
+}
+
+
+void
+OSMDocument::keep_only(Id_bitmap &&nodes, Id_bitmap &&ways) {
+    m_keep_only = true;
+    m_kept_nodes = std::move(nodes);
+    m_kept_ways = std::move(ways);
 }
 
 
@@ -78,24 +89,36 @@ OSMDocument::wait_child() const {
 
 void
 OSMDocument::AddNode(const Node &n) {
+    if (!keeps(n.osm_id())) return;
+
     if (m_vm.count("addnodes")) {
         if ((m_nodes.size() % m_chunk_size) == 0) {
             wait_child();
             std::cout << "\rCurrent osm_nodes:\t" << m_nodes.size();
-            osm_table_export(m_nodes, "osm_nodes");
+            osm_table_export(m_osm_nodes, "osm_nodes");
             export_pois();
+            m_osm_nodes.clear();
         }
+        m_osm_nodes.push_back(n);
     }
 
-    m_nodes.push_back(n);
+    m_nodes.add(n);
 }
 
 void 
 OSMDocument::AddWay(const Way &w) {
+    /*
+     * a way that is not routable would be skipped by the export
+     * (its nodes uses are already counted)
+     */
+    if (m_keep_only && !m_kept_ways.test(w.osm_id())) return;
+
     if (m_ways.empty() && m_vm.count("addnodes")) {
         wait_child();
-        osm_table_export(m_nodes, "osm_nodes");
+        osm_table_export(m_osm_nodes, "osm_nodes");
         export_pois();
+        m_osm_nodes.clear();
+        m_osm_nodes.shrink_to_fit();
         std::cout << "\nFinal osm_nodes:\t" << m_nodes.size() << "\n";
     }
 
@@ -125,6 +148,11 @@ OSMDocument::AddRelation(const Relation &r) {
     }
 }
 
+void
+OSMDocument::endOfNodes() {
+    m_nodes.end_of_nodes();
+}
+
 void
 OSMDocument::endOfFile() {
     
@@ -154,16 +182,9 @@ less(const T &item, const int64_t &id) {
 }
 
 
-Node*
-OSMDocument::FindNode(int64_t node_id) {
-    auto it = std::lower_bound(m_nodes.begin(), m_nodes.end(), node_id, less<Node>); 
-    return &*it;
-}
-
 bool
 OSMDocument::has_node(int64_t node_id) const {
-    auto it = std::lower_bound(m_nodes.begin(), m_nodes.end(), node_id, less<Node>); 
-    return (it != m_nodes.end());
+    return m_nodes.find(node_id) != Node_store::npos;
 }
 
 Way*
@@ -175,27 +196,54 @@ OSMDocument::FindWay(int64_t way_id) {
 bool
 OSMDocument::has_way(int64_t way_id) const {
     auto it = std::lower_bound(m_ways.begin(), m_ways.end(), way_id, less<Way>); 
-    return (it != m_ways.end());
+    return (it != m_ways.end() && it->osm_id() == way_id);
 }
 
 void
-OSMDocument::add_node(Way &way, const char **atts) {
-    auto **attribut = atts;
-    std::string key = *attribut++;
-    std::string value = *attribut++;
-    auto node_id =  (key == "ref")?  boost::lexical_cast<int64_t>(value): -1;
-    way.add_node(node_id);
-
-#if 1
-    // TODO leave this when splitting
-    if (!has_node(node_id)) {
-        ++m_nodeErrs;
-    } else {
-        auto node = FindNode(node_id);
-        node->incrementUse();
-        way.add_node(node);
+OSMDocument::add_node(Way &way, const char **atts) const {
+    way.add_node(strcmp(atts[0], "ref") == 0 ?
+            static_cast<int64_t>(strtoll(atts[1], nullptr, 10)) : -1);
+}
+
+void
+OSMDocument::find_nodes(Way &way) const {
+    std::vector<size_t> positions;
+    m_nodes.find(way.node_ids(), positions);
+    for (const auto position : positions) {
+        if (position != Node_store::npos) way.add_node_index(position);
     }
-#endif
+}
+
+void
+OSMDocument::find_nodes(Ways::iterator begin, Ways::iterator end) const {
+    std::vector<int64_t> ids;
+    for (auto way = begin; way != end; ++way) {
+        ids.insert(ids.end(), way->node_ids().begin(), way->node_ids().end());
+    }
+
+    std::vector<size_t> positions;
+    m_nodes.find(ids, positions);
+
+    auto position = positions.begin();
+    for (auto way = begin; way != end; ++way) {
+        for (size_t i = 0; i < way->node_ids().size(); ++i, ++position) {
+            if (*position != Node_store::npos) way->add_node_index(*position);
+        }
+    }
+}
+
+void
+OSMDocument::use_nodes(Way &way) {
+    size_t expected = 0;
+    for (const auto id : way.node_ids()) {
+        if (keeps(id)) ++expected;
+    }
+    m_nodeErrs = static_cast<uint16_t>(
+            m_nodeErrs + expected - way.nodeRefs().size());
+    for (auto node : way.nodeRefs()) {
+        m_nodes.incrementUse(node);
+    }
+    if (!m_vm.count("addnodes")) way.drop_node_ids();
 }
 
 /*
@@ -225,14 +273,14 @@ OSMDocument::add_config(Element *item, const Tag &tag) const {
 
 static
 bool
-has_no_tags(const Node &node) {
-    return !node.has_tags();
+has_tags(const Node &node) {
+    return node.has_tags();
 }
 
 void
 OSMDocument::export_pois() const {
     std::string table("pointsofinterest");
-    if (m_nodes.empty()) return;
+    if (m_osm_nodes.empty()) return;
 
 #if 0
     if (m_vm.count("fork")) {
@@ -246,19 +294,17 @@ OSMDocument::export_pois() const {
 #endif
 
 
-    auto residue = m_nodes.size() % m_chunk_size;
-    size_t start = residue? m_nodes.size() - residue : m_nodes.size() - m_chunk_size;
+    auto residue = m_osm_nodes.size() % m_chunk_size;
+    size_t start = residue? m_osm_nodes.size() - residue : m_osm_nodes.size() - m_chunk_size;
 
-    auto export_items = Nodes(m_nodes.begin() + start, m_nodes.end());
     /*
-     * deleting nodes with no tag information
+     * skipping nodes with no tag information
      */
-    export_items.erase(
-            std::remove_if(export_items.begin(), export_items.end(), has_no_tags),
-            export_items.end());
+    auto begin = boost::make_filter_iterator(has_tags, m_osm_nodes.begin() + start, m_osm_nodes.end());
+    auto end = boost::make_filter_iterator(has_tags, m_osm_nodes.end(), m_osm_nodes.end());
 
-    if (!export_items.empty()) {
-        m_db_conn.export_osm(export_items, table);
+    if (begin != end) {
+        m_db_conn.export_osm(begin, end, table);
     }
 
 #if 0
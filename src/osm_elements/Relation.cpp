@@ -22,6 +22,7 @@
 #include <boost/lexical_cast.hpp>
 #include <string>
 #include "osm_elements/Relation.h"
+#include "utilities/number_format.h"
 
 namespace osm2pgr {
 
@@ -68,7 +69,7 @@ std::string
 Relation::members_str() const {
     std::string way_list("");
     for (const auto &way_ref : m_WayRefs) {
-        way_list += boost::lexical_cast<std::string>(way_ref)
+        way_list += number_str(way_ref)
         /*
          * currently only adding way
          */
@@ -30,6 +30,8 @@
 #include "osm_elements/OSMDocument.h"
 #include "osm_elements/osm_tag.h"
 #include "osm_elements/Node.h"
+#include "utilities/number_format.h"
+#include "utilities/geodesic.h"
 
 
 
@@ -59,35 +61,20 @@ Way::add_node(int64_t node_id) {
 }
 
 void
-Way::add_node(Node *node) {
-    assert(node);
-    m_NodeRefs.push_back(node);
+Way::add_node_index(size_t index) {
+    assert(index != Node_store::npos);
+    m_NodeRefs.push_back(index);
 }
 
 
 std::string
-Way::get_geometry() const {
-    return geometry_str(m_NodeRefs);
-}
-
-std::string
-Way::length_str() const {
-    return length_str(m_NodeRefs);
-}
-
-
-std::string
-Way::geometry_str(const std::vector<Node*> &nodeRefs) const {
-    if (nodeRefs.size() < 2) return "srid=4326;LINESTRING EMPTY";
+Way::geometry_str(const Node_store &nodes, const Split &split) const {
+    if (split.end - split.begin < 2) return "srid=4326;LINESTRING EMPTY";
 
     std::string geometry("srid=4326;LINESTRING(");
 
-    for (auto it = nodeRefs.begin();
-            it != nodeRefs.end();
-            ++it) {
-        auto node_ptr = *it;
-
-        geometry += node_ptr->geom_str(" ");
+    for (auto i = split.begin; i < split.end; ++i) {
+        geometry += nodes.geom_str(m_NodeRefs[i], " ");
         geometry += ", ";
     }
     geometry[geometry.size() - 2] = ')';
@@ -95,61 +82,70 @@ Way::geometry_str(const std::vector<Node*> &nodeRefs) const {
 }
 
 
-std::string
-Way::length_str(const std::vector<Node*> &nodeRefs) const {
+double
+Way::length(const Node_store &nodes, const Split &split) const {
     double length = 0;
-    auto prev_node_ptr = nodeRefs.front();
+    for (auto i = split.begin + 1; i < split.end; ++i) {
+        length  += nodes.getLength(m_NodeRefs[i], m_NodeRefs[i - 1]);
+    }
+    return length;
+}
 
-    for (auto it = nodeRefs.begin();
-            it != nodeRefs.end();
-            ++it) {
-        auto node_ptr = *it;
 
-        length  += node_ptr->getLength(*prev_node_ptr);
-        prev_node_ptr = node_ptr;
+double
+Way::length_m(const Node_store &nodes, const Split &split) const {
+    /*
+     * the coordinates of the split are gathered in buffers kept by the thread
+     */
+    thread_local std::vector<int32_t> lons;
+    thread_local std::vector<int32_t> lats;
+    lons.clear();
+    lats.clear();
+    for (auto i = split.begin; i < split.end; ++i) {
+        lons.push_back(nodes.fixed_lon(m_NodeRefs[i]));
+        lats.push_back(nodes.fixed_lat(m_NodeRefs[i]));
     }
+    return geodesic_length(lons.data(), lats.data(), lons.size());
+}
 
-    return boost::lexical_cast<std::string>(length);
+
+std::string
+Way::length_str(const Node_store &nodes, const Split &split) const {
+    return number_str(length(nodes, split));
 }
 
 
 
-std::vector<std::vector<Node*>>
-Way::split_me() {
-    if (nodeRefs().size() < 2) {
+void
+Way::split_me(const Node_store &nodes, std::vector<Split> &splits) const {
+    splits.clear();
+    if (m_NodeRefs.size() < 2) {
         /*
          * The way is ill formed
          */
-        return std::vector<std::vector<Node*>>();
+        return;
     }
 
-    std::vector<std::vector<Node*>> m_split_ways;
-    auto it_node(nodeRefs().begin());
-    auto last_node(nodeRefs().end());
-
-    while (it_node != last_node) {
+    auto count = m_NodeRefs.size();
+    size_t node = 0;
+    while (node < count) {
         /*
          * starting a new split
          */
-        std::vector<Node*> split_way;
-        split_way.push_back(*it_node);
+        auto begin = node;
+        ++node;
 
-        ++it_node;
-
-        if (it_node != last_node) {
-            while (it_node != last_node) {
-                split_way.push_back(*it_node);
-
-                if ((*it_node)->numsOfUse() > 1) {
-                    break;
-                }
-                ++it_node;
-            }
+        while (node < count && nodes.numsOfUse(m_NodeRefs[node]) <= 1) {
+            ++node;
         }
 
-        if (split_way.size() > 1) m_split_ways.push_back(split_way);
+        /*
+         * the split ends on the node used by other ways,
+         * the next split starts on it
+         */
+        auto end = node < count ? node + 1 : count;
+        if (end - begin > 1) splits.push_back(Split{begin, end});
     }
-    return m_split_ways;
 }
 
 
@@ -299,14 +295,19 @@ Way::max_speed(const Tag &tag) {
 }
 
 
+int
+Way::oneWayType() const {
+    if (m_oneWay == "YES") return 1;
+    if (m_oneWay == "NO") return  2;
+    if (m_oneWay == "REVERSIBLE") return  3;
+    if (m_oneWay == "REVERSED") return -1;
+    if (m_oneWay == "UNKNOWN") return 0;
+    return 0;
+}
+
 std::string
 Way::oneWayType_str() const {
-    if (m_oneWay == "YES") return "1";
-    if (m_oneWay == "NO") return  "2";
-    if (m_oneWay == "REVERSIBLE") return  "3";
-    if (m_oneWay == "REVERSED") return "-1";
-    if (m_oneWay == "UNKNOWN") return "0";
-    return "0";
+    return number_str(oneWayType());
 }
 
 void
@@ -322,7 +323,7 @@ Way::members_str() const {
     /* this list comes from the node_ids becuase a node might not be on the file */
     std::string node_list("");
     for (const auto &node_id : m_node_ids) {
-        node_list += boost::lexical_cast<std::string>(node_id) + "=>\"type=>nd\",";
+        node_list += number_str(node_id) + "=>\"type=>nd\",";
     }
     node_list[node_list.size() -1] = ' ';
 
@@ -343,9 +344,8 @@ std::ostream& operator<<(std::ostream &os, const Way &way) {
     std::cout << "\n\n ************ attributes: " << way.attributes_str();
     std::cout << "\n\n ************ tags: " << way.tags_str();
     std::cout << "\n nodes: \n";
-    for (auto it = way.m_NodeRefs.begin(); it != way.m_NodeRefs.end(); ++it) {
-        auto e = *it;
-        std::cout << e->osm_id() << ", ";
+    for (auto it = way.m_node_ids.begin(); it != way.m_node_ids.end(); ++it) {
+        std::cout << *it << ", ";
     }
 
     return os;
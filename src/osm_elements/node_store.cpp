@@ -0,0 +1,156 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+#include "osm_elements/node_store.h"
+
+#include <math.h>
+#include <algorithm>
+#include <iostream>
+
+namespace osm2pgr {
+
+const size_t Node_store::npos;
+
+
+bool
+Node_store::map(const std::string &file) {
+    return m_ids.map(file + ".ids")
+        && m_lats.map(file + ".lats")
+        && m_lons.map(file + ".lons")
+        && m_uses.map(file + ".uses");
+}
+
+
+void
+Node_store::add(const Node &node) {
+    auto lat = Node::fixed_point(node.get_attribute("lat"));
+    auto lon = flip(Node::fixed_point(node.get_attribute("lon")));
+
+    if (!m_dense) {
+        m_ids.push_back(node.osm_id());
+        m_lats.push_back(lat);
+        m_lons.push_back(lon);
+        m_uses.push_back(node.numsOfUse());
+        ++m_count;
+        return;
+    }
+
+    if (node.osm_id() < 0) {
+        if (m_negatives++ == 0) {
+            std::cerr << "Nodes with a negative id are not kept by the dense layout\n";
+        }
+        return;
+    }
+    auto i = static_cast<size_t>(node.osm_id());
+    if (i >= m_lons.size()) {
+        m_lats.resize(i + 1);
+        m_lons.resize(i + 1);
+        m_uses.resize(i + 1);
+    }
+    m_lats[i] = lat;
+    m_lons[i] = lon;
+    m_uses[i] = node.numsOfUse();
+    ++m_count;
+}
+
+
+void
+Node_store::end_of_nodes() {
+    if (!m_use_rank_index || m_dense || m_ids.empty()) return;
+    m_use_rank_index = false;
+
+    for (size_t i = 1; i < m_ids.size(); ++i) {
+        if (m_ids[i - 1] >= m_ids[i]) {
+            std::cerr << "The nodes are not sorted by id: the rank index is not used\n";
+            return;
+        }
+    }
+
+    auto first = std::lower_bound(m_ids.begin(), m_ids.end(), 0);
+    m_negatives = static_cast<size_t>(first - m_ids.begin());
+    m_rank_index.build(first, m_ids.end());
+}
+
+
+size_t
+Node_store::find(int64_t osm_id) const {
+    if (m_dense) {
+        auto i = static_cast<size_t>(osm_id);
+        return osm_id >= 0 && i < m_lons.size() && m_lons[i] != 0 ? i : npos;
+    }
+
+    if (!m_rank_index.empty() && osm_id >= 0) {
+        size_t rank;
+        return m_rank_index.find(osm_id, rank) ? m_negatives + rank : npos;
+    }
+
+    auto it = std::lower_bound(m_ids.begin(), m_ids.end(), osm_id);
+    if (it == m_ids.end() || *it != osm_id) return npos;
+    return static_cast<size_t>(it - m_ids.begin());
+}
+
+
+void
+Node_store::find(const std::vector<int64_t> &osm_ids, std::vector<size_t> &positions) const {
+    positions.resize(osm_ids.size());
+    if (m_dense || !m_rank_index.empty()) {
+        for (size_t i = 0; i < osm_ids.size(); ++i) positions[i] = find(osm_ids[i]);
+        return;
+    }
+
+    std::vector<size_t> order(osm_ids.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&osm_ids](size_t a, size_t b) {
+            return osm_ids[a] < osm_ids[b];
+            });
+
+    /*
+     * merge: the next id is after the current one,
+     * it is found by galloping from the current position
+     */
+    auto ids = m_ids.begin();
+    auto end = m_ids.end();
+    for (const auto i : order) {
+        auto osm_id = osm_ids[i];
+        size_t step = 1;
+        auto from = ids;
+        while (static_cast<size_t>(end - from) > step && from[step] < osm_id) {
+            from += step;
+            step *= 2;
+        }
+        auto to = static_cast<size_t>(end - from) > step ? from + step + 1 : end;
+        ids = std::lower_bound(from, to, osm_id);
+
+        positions[i] = ids != end && *ids == osm_id ?
+            static_cast<size_t>(ids - m_ids.begin()) : npos;
+    }
+}
+
+
+double
+Node_store::getLength(size_t i, size_t previous) const {
+    auto y1 = m_lats[i] / 1e7;
+    auto x1 = longitude(i) / 1e7;
+    auto y2 = m_lats[previous] / 1e7;
+    auto x2 = longitude(previous) / 1e7;
+    return sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
+}
+
+}  // namespace osm2pgr
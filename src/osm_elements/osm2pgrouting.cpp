@@ -24,6 +24,8 @@
 #endif
 
 #include <unistd.h>
+#include <errno.h>
+#include <string.h>
 #include <string>
 #include <iostream>
 
@@ -36,39 +38,24 @@
 
 #include "parser/ConfigurationParserCallback.h"
 #include "parser/OSMDocumentParserCallback.h"
+#include "parser/PBFParser.h"
+#include "parser/ParallelXMLParser.h"
+#include "parser/RoutableScanCallback.h"
 #include "osm_elements/OSMDocument.h"
 #include "database/Export2DB.h"
 #include "utilities/handle_pgpass.h"
 #include "utilities/prog_options.h"
 
-#if defined(__linux__)
-static
-size_t lines_in_file(const std::string file_name) {
-    FILE *in;
-    char buff[512];
-    std::string command = "wc -l  " + file_name;
-
-    if (!(in = popen(command.c_str(), "r"))) {
-        std::cerr << "File not found" << file_name << "\n";
-        exit(1);
-    }
 
-    std::string word;
-    if (fgets(buff, 512, in) != NULL) {
-        word = buff;
-    }
-    pclose(in);
-    std::istringstream iss(word);
-    std::string number;
-    iss >> number;
-    try {
-        return boost::lexical_cast<size_t>(number);
-    } catch (...) {
-        std::cerr << "File not found" << file_name << "\n";
-        exit(1);
-    }
+template <typename P>
+static
+void
+print_throughput(const P &parser) {
+    std::cout << "    Read "
+        << static_cast<double>(parser.bytes()) / (1024 * 1024) << " MB in "
+        << parser.seconds() << " seconds: "
+        << parser.throughput() << " MB/s\n";
 }
-#endif
 
 
 int main(int argc, char* argv[]) {
@@ -112,6 +99,24 @@ int main(int argc, char* argv[]) {
             return 0;
         }
 
+        if (vm["nodes-layout"].as<std::string>() != "sparse"
+                && vm["nodes-layout"].as<std::string>() != "dense") {
+            std::cout << "--nodes-layout must be sparse or dense\n";
+            std::cout << od_desc << "\n";
+            return 1;
+        }
+
+        /*
+         * dense: the nodes are indexed by their id,
+         * only the memory mapped files can hold that range
+         */
+        if (vm["nodes-layout"].as<std::string>() == "dense"
+                && !vm.count("nodes-file")) {
+            std::cout << "--nodes-layout dense requires --nodes-file\n";
+            std::cout << od_desc << "\n";
+            return 1;
+        }
+
 #ifdef WITH_TIME
         std::cout << "Execution starts at: " << std::ctime(&start_t) << "\n";
 #endif
@@ -200,24 +205,70 @@ int main(int argc, char* argv[]) {
         std::cout << "  - Done \n";
 
 
-#if defined(__linux__)
-        std::cout << "Counting lines ...\n";
-        auto total_lines = lines_in_file(dataFile);
-        std::cout << "  - Done \n";
-
-        std::cout << "Opening data file: "
-            << dataFile
-            << "\ttotal lines: "
-            << total_lines
-            << endl;
-#else
-        size_t total_lines = 0;
-#endif
-        osm2pgr::OSMDocument document(config, vm, dbConnection, total_lines);
+        auto is_pbf(pbf::PBFParser::is_pbf(dataFile));
+        std::cout << "Opening data file: " << dataFile << endl;
+        osm2pgr::OSMDocument document(config, vm, dbConnection);
         osm2pgr::OSMDocumentParserCallback callback(document);
+        if (vm.count("nodes-file")
+                && !document.map_nodes(vm["nodes-file"].as<std::string>())) {
+            cerr << "Failed to create the nodes file "
+                << vm["nodes-file"].as<std::string>() << ": " << strerror(errno) << endl;
+            return 1;
+        }
+
+        auto threads(vm["threads"].as<size_t>());
+        auto read_size(vm["read-size"].as<size_t>() * 1024 * 1024);
+
+        /*
+         * the first pass reads the file once more (twice when relations
+         * make ways routable) for every format: a compressed XML file is
+         * decompressed each time, --one-pass keeps all its nodes instead
+         */
+        if (!vm.count("addnodes") && !vm.count("one-pass")) {
+            /*
+             * first pass: only the routable ways and their nodes are kept
+             */
+            std::cout << "    Finding the nodes of the routable ways\n" << endl;
+            osm2pgr::RoutableScanCallback scan(config);
+            auto scan_file = [&]() {
+                if (is_pbf) {
+                    pbf::PBFParser pbf_parser(vm["threads"].defaulted() ? 0 : threads);
+                    return pbf_parser.Parse(scan, dataFile.c_str());
+                }
+                xml::XMLParser scan_parser(read_size, true);
+                return scan_parser.Parse(scan, dataFile.c_str());
+            };
+            ret = scan_file();
+            if (ret == 0 && scan.members_pending()) {
+                std::cout << "    Finding the nodes of the ways of the routable relations\n" << endl;
+                scan.start_members_pass();
+                ret = scan_file();
+            }
+            if (ret != 0) {
+                cerr << "Failed to open / parse data file " << dataFile << endl;
+                return 1;
+            }
+            std::cout << "    Routable ways: " << scan.ways().size()
+                << "\tNodes of the routable ways: " << scan.nodes().size() << "\n";
+            document.keep_only(std::move(scan.nodes()), std::move(scan.ways()));
+        }
 
         std::cout << "    Parsing data\n" << endl;
-        ret = parser.Parse(callback, dataFile.c_str());
+        if (is_pbf) {
+            /*
+             * all the cores decode the blocks unless told otherwise
+             */
+            pbf::PBFParser pbf_parser(vm["threads"].defaulted() ? 0 : threads);
+            ret = pbf_parser.Parse(callback, dataFile.c_str());
+        } else if (threads != 1 && !vm.count("no-mmap")) {
+            osm2pgr::ParallelXMLParser data_parser(document, threads, read_size);
+            ret = data_parser.Parse(dataFile.c_str());
+            if (ret == 0) print_throughput(data_parser);
+        } else {
+            xml::XMLParser data_parser(read_size, true);
+            ret = data_parser.Parse(callback, dataFile.c_str());
+            if (ret == 0) print_throughput(data_parser);
+        }
         if (ret != 0) {
             cerr << "Failed to open / parse data file " << dataFile << endl;
             return 1;
@@ -234,7 +285,7 @@ int main(int argc, char* argv[]) {
 
 
             std::cout << "\nExport Ways ..." << endl;
-            dbConnection.exportWays(document.ways(), config);
+            dbConnection.exportWays(document.ways(), document.nodes(), config);
 
             if (!no_index) {
                 std::cout << "\nCreating indexes ..." << endl;
@@ -244,6 +295,9 @@ int main(int argc, char* argv[]) {
             std::cout << "\nProcessing Points of Interest ..." << endl;
             dbConnection.process_pois();
 
+            std::cout << "\nFinishing the load ..." << endl;
+            dbConnection.finish_load();
+
         }
 
 
@@ -24,6 +24,7 @@
 #include <string>
 #include "osm_elements/osm_tag.h"
 #include "osm_elements/osm_element.h"
+#include "utilities/number_format.h"
 
 namespace osm2pgr {
 
@@ -121,18 +122,11 @@ addquotes(const std::string str, bool force) {
             result += "\'\'";
             continue;
         } else if ( c == '\\' ) {
+            /*
+             * hstore escaping only: the escaping of the COPY
+             * is done when the field is written in the rows
+             */
             result += '\\';
-        } else if (c == '\'') {
-            result += '\'';
-        } else if (c == '\n') {
-            result += "\\n";
-            continue;
-        } else if (c == '\r') {
-            result += "\\r";
-            continue;
-        } else if (c == '\t') {
-            result += "\\t";
-            continue;
         }
         result += c;
     }
@@ -185,9 +179,9 @@ getJSON(const std::map<std::string, std::string> &values) {
 std::vector<std::string>
 Element::values(const std::vector<std::string> &columns, bool is_hstore) const {
     std::vector<std::string> values;
-    for (const auto column : columns) {
+    for (const auto &column : columns) {
         if (column == "osm_id" || column == "tag_id") { 
-            values.push_back(boost::lexical_cast<std::string>(osm_id()));
+            values.push_back(number_str(osm_id()));
             continue;
         }   
         if (column == "tag_name") {
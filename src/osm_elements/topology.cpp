@@ -0,0 +1,189 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+#include "osm_elements/topology.h"
+
+#include <algorithm>
+#include <future>
+#include <vector>
+
+#include "osm_elements/node_store.h"
+#include "osm_elements/Way.h"
+#include "utilities/thread_pool.h"
+
+namespace osm2pgr {
+
+namespace {
+
+/*
+ * hash of the node sequence of a split
+ */
+uint64_t
+nodes_hash(const Way &way, const Way::Split &split) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (auto i = split.begin; i < split.end; ++i) {
+        uint64_t value = way.nodeRefs()[i];
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        hash = (hash ^ value) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+}  // namespace
+
+
+/*
+ * The ways are split in batches on the pool,
+ * each batch returns the sorted positions of its vertices
+ * and its splits in way order
+ */
+void
+Topology::build(
+        const std::vector<Way> &ways,
+        const Node_store &nodes,
+        Thread_pool &pool) {
+    typedef std::vector<Way>::const_iterator Iterator;
+    auto batch_size = std::max(
+            static_cast<size_t>(1),
+            (ways.size() + pool.size() - 1) / pool.size());
+
+    typedef std::pair<std::vector<size_t>, std::vector<Edge>> Batch;
+    std::vector<std::future<Batch>> batches;
+    for (size_t i = 0; i < ways.size(); i += batch_size) {
+        auto begin = ways.begin() + static_cast<ptrdiff_t>(i);
+        auto end = ways.begin() + static_cast<ptrdiff_t>(std::min(i + batch_size, ways.size()));
+        batches.push_back(pool.submit([begin, end, &nodes] {
+                    Batch batch;
+                    auto &positions = batch.first;
+                    std::vector<Way::Split> splits;
+                    for (Iterator it = begin; it != end; ++it) {
+                        if (it->tag_config().key() == "" || it->tag_config().value() == "") continue;
+                        it->split_me(nodes, splits);
+                        for (const auto &split : splits) {
+                            positions.push_back(it->first_node(split));
+                            positions.push_back(it->last_node(split));
+                            batch.second.push_back(Edge{nodes_hash(*it, split), &*it, split.begin, split.end});
+                        }
+                    }
+                    std::sort(positions.begin(), positions.end());
+                    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+                    return batch;
+                    }));
+    }
+
+    m_positions.clear();
+    std::vector<Edge> edges;
+    for (auto &future : batches) {
+        auto batch = future.get();
+        const auto &positions = batch.first;
+        edges.insert(edges.end(), batch.second.begin(), batch.second.end());
+        auto middle = m_positions.size();
+        m_positions.insert(m_positions.end(), positions.begin(), positions.end());
+        std::inplace_merge(m_positions.begin(), m_positions.begin() + static_cast<ptrdiff_t>(middle), m_positions.end());
+    }
+    m_positions.erase(std::unique(m_positions.begin(), m_positions.end()), m_positions.end());
+    m_ids.assign(m_positions.size(), 0);
+
+    find_duplicates(edges);
+}
+
+
+/*
+ * The edges are sorted by hash, then in way order:
+ * in a run of equal hashes the node sequences are compared
+ * with the first split of each sequence of the run
+ */
+void
+Topology::find_duplicates(std::vector<Edge> &edges) {
+    std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+            if (a.hash != b.hash) return a.hash < b.hash;
+            if (a.way != b.way) return a.way < b.way;
+            return a.begin < b.begin;
+            });
+
+    auto same_nodes = [](const Edge &a, const Edge &b) {
+        if (a.end - a.begin != b.end - b.begin) return false;
+        auto first = a.way->nodeRefs().begin();
+        return std::equal(
+                first + static_cast<ptrdiff_t>(a.begin),
+                first + static_cast<ptrdiff_t>(a.end),
+                b.way->nodeRefs().begin() + static_cast<ptrdiff_t>(b.begin));
+    };
+
+    m_duplicates.clear();
+    std::vector<const Edge*> kept;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (i == 0 || edges[i].hash != edges[i - 1].hash) kept.clear();
+        const auto &edge = edges[i];
+        auto duplicate = std::any_of(kept.begin(), kept.end(), [&](const Edge *other) {
+                return same_nodes(*other, edge);
+                });
+        if (duplicate) {
+            m_duplicates.emplace_back(edge.way, edge.begin);
+        } else {
+            kept.push_back(&edge);
+        }
+    }
+    std::sort(m_duplicates.begin(), m_duplicates.end());
+}
+
+
+bool
+Topology::is_duplicate(const Way &way, const Way::Split &split) const {
+    return std::binary_search(
+            m_duplicates.begin(), m_duplicates.end(),
+            std::make_pair(&way, split.begin));
+}
+
+
+void
+Topology::existing(int64_t osm_id, int64_t id, const Node_store &nodes) {
+    auto position = nodes.find(osm_id);
+    if (position == Node_store::npos) return;
+    auto i = find(position);
+    if (i != size()) m_ids[i] = id;
+}
+
+
+void
+Topology::number(int64_t first_id) {
+    m_first_new = first_id;
+    for (auto &id : m_ids) {
+        if (id == 0) id = first_id++;
+    }
+}
+
+
+int64_t
+Topology::id(size_t position) const {
+    auto i = find(position);
+    return i == size() ? 0 : m_ids[i];
+}
+
+
+size_t
+Topology::find(size_t position) const {
+    auto it = std::lower_bound(m_positions.begin(), m_positions.end(), position);
+    if (it == m_positions.end() || *it != position) return size();
+    return static_cast<size_t>(it - m_positions.begin());
+}
+
+}  // end namespace osm2pgr
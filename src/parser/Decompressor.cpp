@@ -0,0 +1,248 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+#include "parser/Decompressor.h"
+
+#include <sys/stat.h>
+#include <zlib.h>
+#include <bzlib.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <climits>
+
+
+namespace xml {
+
+/*
+ * size of the compressed reads
+ */
+static const size_t IN_SIZE = 1024 * 1024;
+
+
+Decompressor::Format
+Decompressor::format(FILE *fp) {
+    /*
+     * only a regular file can be rewound after looking at its magic number
+     */
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)) return NONE;
+
+    unsigned char magic[3] = {0, 0, 0};
+    auto len = fread(magic, 1, sizeof(magic), fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (len >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) return GZIP;
+    if (len == 3 && magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h') return BZIP2;
+    return NONE;
+}
+
+
+Decompressor::Decompressor(
+        FILE *fp,
+        Format format,
+        size_t buffer_size,
+        size_t queue_size) :
+    m_fp(fp),
+    m_format(format),
+    m_buffer_size(std::min(std::max(buffer_size, IN_SIZE), static_cast<size_t>(UINT_MAX))),
+    m_queue(queue_size),
+    m_compressed_bytes(0) {
+        m_thread = std::thread([this] {run();});
+    }
+
+
+Decompressor::~Decompressor() {
+    /*
+     * the parser might stop before the end of the data:
+     * closing the queue makes the decompressing thread stop
+     */
+    m_queue.close();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+
+bool
+Decompressor::next(std::vector<char> &buffer) {
+    if (!m_queue.pop(buffer)) {
+        /*
+         * the queue is closed by the decompressing thread
+         * so m_error is safe to read
+         */
+        return false;
+    }
+    return true;
+}
+
+
+void
+Decompressor::run() {
+    if (m_format == GZIP) gunzip();
+    if (m_format == BZIP2) bunzip2();
+    m_queue.close();
+}
+
+
+size_t
+Decompressor::read(std::vector<char> &in) {
+    auto len = fread(in.data(), 1, in.size(), m_fp);
+    if (ferror(m_fp)) {
+        m_error = std::string("Error reading: ") + strerror(errno);
+        return 0;
+    }
+    m_compressed_bytes += len;
+    return len;
+}
+
+
+void
+Decompressor::gunzip() {
+    std::vector<char> in(IN_SIZE);
+    std::vector<char> out(m_buffer_size);
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    /*
+     * 32: zlib or gzip header detection
+     */
+    if (inflateInit2(&strm, 15 + 32) != Z_OK) {
+        m_error = "Error initializing zlib";
+        return;
+    }
+
+    strm.next_out = reinterpret_cast<Bytef*>(out.data());
+    strm.avail_out = static_cast<uInt>(out.size());
+
+    bool eof(false);
+    bool in_stream(false);
+    while (true) {
+        if (strm.avail_in == 0 && !eof) {
+            auto len = read(in);
+            if (!m_error.empty()) break;
+            eof = len == 0;
+            strm.next_in = reinterpret_cast<Bytef*>(in.data());
+            strm.avail_in = static_cast<uInt>(len);
+        }
+        if (strm.avail_in == 0 && eof) {
+            if (in_stream) m_error = "Unexpected end of the gzip file";
+            break;
+        }
+
+        in_stream = true;
+        auto status = inflate(&strm, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            /*
+             * concatenated gzip members
+             */
+            in_stream = false;
+            inflateReset(&strm);
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            m_error = std::string("Error decompressing: ") + (strm.msg ? strm.msg : "zlib error");
+            break;
+        }
+
+        if (strm.avail_out == 0) {
+            if (!m_queue.push(std::move(out))) break;
+            out = std::vector<char>(m_buffer_size);
+            strm.next_out = reinterpret_cast<Bytef*>(out.data());
+            strm.avail_out = static_cast<uInt>(out.size());
+        }
+    }
+
+    if (m_error.empty()) {
+        out.resize(out.size() - strm.avail_out);
+        if (!out.empty()) m_queue.push(std::move(out));
+    }
+    inflateEnd(&strm);
+}
+
+
+void
+Decompressor::bunzip2() {
+    std::vector<char> in(IN_SIZE);
+    std::vector<char> out(m_buffer_size);
+
+    bz_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
+        m_error = "Error initializing bzip2";
+        return;
+    }
+
+    strm.next_out = out.data();
+    strm.avail_out = static_cast<unsigned int>(out.size());
+
+    bool eof(false);
+    bool in_stream(false);
+    while (true) {
+        if (strm.avail_in == 0 && !eof) {
+            auto len = read(in);
+            if (!m_error.empty()) break;
+            eof = len == 0;
+            strm.next_in = in.data();
+            strm.avail_in = static_cast<unsigned int>(len);
+        }
+        if (strm.avail_in == 0 && eof) {
+            if (in_stream) m_error = "Unexpected end of the bzip2 file";
+            break;
+        }
+
+        in_stream = true;
+        auto status = BZ2_bzDecompress(&strm);
+        if (status == BZ_STREAM_END) {
+            /*
+             * concatenated bzip2 streams (pbzip2, planet files):
+             * a new stream starts with the remaining input
+             */
+            in_stream = false;
+            auto next_in = strm.next_in;
+            auto avail_in = strm.avail_in;
+            auto next_out = strm.next_out;
+            auto avail_out = strm.avail_out;
+            BZ2_bzDecompressEnd(&strm);
+            memset(&strm, 0, sizeof(strm));
+            if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
+                m_error = "Error initializing bzip2";
+                return;
+            }
+            strm.next_in = next_in;
+            strm.avail_in = avail_in;
+            strm.next_out = next_out;
+            strm.avail_out = avail_out;
+        } else if (status != BZ_OK) {
+            m_error = "Error decompressing: bzip2 error " + std::to_string(status);
+            break;
+        }
+
+        if (strm.avail_out == 0) {
+            if (!m_queue.push(std::move(out))) break;
+            out = std::vector<char>(m_buffer_size);
+            strm.next_out = out.data();
+            strm.avail_out = static_cast<unsigned int>(out.size());
+        }
+    }
+
+    if (m_error.empty()) {
+        out.resize(out.size() - strm.avail_out);
+        if (!out.empty()) m_queue.push(std::move(out));
+    }
+    BZ2_bzDecompressEnd(&strm);
+}
+
+}  // end namespace xml
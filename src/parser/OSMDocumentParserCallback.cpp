@@ -32,7 +32,6 @@
 #include "osm_elements/osm_tag.h"
 #include "osm_elements/Way.h"
 #include "osm_elements/Node.h"
-#include "utilities/print_progress.h"
 
 
 namespace osm2pgr {
@@ -54,23 +53,6 @@ namespace osm2pgr {
   </relation>
  */
 
-void
-OSMDocumentParserCallback::show_progress() {
-#if 0
-    try {
-        if (m_line == 0) return;
-        assert(m_rDocument.lines());
-        if (m_rDocument.lines() == 0) return;
-        if (((++m_line) % (m_rDocument.lines() / 100)) == 0) {
-            print_progress(m_rDocument.lines(), m_line);
-        }
-    } catch(...) {
-        m_line = 1;
-    }
-#endif
-}
-
-
 /**
   Parser callback for OSMDocument files
   */
@@ -78,15 +60,20 @@ void
 OSMDocumentParserCallback::StartElement(
         const char *name,
         const char** atts) {
-    show_progress();
-
     if (strcmp(name, "osm") == 0) {
-        m_section = 1;
+        m_section = m_first_section;
     }
 
-    if ((m_section == 1 && (strcmp(name, "way") == 0))
-            || (m_section == 2 && (strcmp(name, "relation") == 0))) {
-        ++m_section;
+    /*
+     * the relations also start a section when there are no ways
+     */
+    if (m_section == 1 && (strcmp(name, "way") == 0)) {
+        m_section = 2;
+        m_rDocument.endOfNodes();
+    }
+    if (m_section < 3 && (strcmp(name, "relation") == 0)) {
+        if (m_section == 1) m_rDocument.endOfNodes();
+        m_section = 3;
     }
 
 
@@ -156,7 +143,6 @@ OSMDocumentParserCallback::StartElement(
 void OSMDocumentParserCallback::EndElement(const char* name) {
     if (strcmp(name, "osm") == 0) {
         m_rDocument.endOfFile();
-        show_progress();
         return;
     }
 
@@ -166,6 +152,8 @@ void OSMDocumentParserCallback::EndElement(const char* name) {
         return;
     }
     if (strcmp(name, "way") == 0) {
+        m_rDocument.find_nodes(*last_way);
+        m_rDocument.use_nodes(*last_way);
         m_rDocument.AddWay(*last_way);
         if (m_rDocument.config_has_tag(last_way->tag_config())) {
 
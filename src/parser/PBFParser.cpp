@@ -0,0 +1,718 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+#include "parser/PBFParser.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utilities/thread_pool.h"
+
+
+namespace pbf {
+
+namespace {
+
+/*
+ * Limits given by the format specification
+ */
+const uint32_t MAX_BLOB_HEADER_SIZE = 64 * 1024;
+const int32_t MAX_BLOB_SIZE = 32 * 1024 * 1024;
+
+class Format_error : public std::runtime_error {
+ public:
+     explicit Format_error(const std::string &what) :
+         std::runtime_error(what) {}
+};
+
+
+/** @brief minimal protocol buffer message reader
+ *
+ * https://developers.google.com/protocol-buffers/docs/encoding
+ */
+class Message {
+ public:
+     enum Wire_type {VARINT = 0, FIXED64 = 1, LENGTH_DELIMITED = 2, FIXED32 = 5};
+
+     Message(const char *data, size_t size) :
+         m_ptr(data),
+         m_end(data + size),
+         m_field(0),
+         m_wire(0) {}
+
+     explicit Message(const std::string &str) :
+         Message(str.data(), str.size()) {}
+
+     inline const char* data() const {return m_ptr;}
+     inline size_t size() const {return static_cast<size_t>(m_end - m_ptr);}
+     inline uint32_t field() const {return m_field;}
+
+     /** moves to the next field, false when there are no more fields */
+     bool next() {
+         if (m_ptr >= m_end) return false;
+         auto key = varint();
+         m_field = static_cast<uint32_t>(key >> 3);
+         m_wire = static_cast<uint32_t>(key & 0x7);
+         return true;
+     }
+
+     uint64_t varint() {
+         uint64_t value = 0;
+         for (unsigned int shift = 0; shift < 64; shift += 7) {
+             if (m_ptr >= m_end) throw Format_error("truncated varint");
+             auto byte = static_cast<uint8_t>(*m_ptr++);
+             value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+             if (!(byte & 0x80)) return value;
+         }
+         throw Format_error("malformed varint");
+     }
+
+     inline int64_t svarint() {return zigzag(varint());}
+
+     static inline int64_t zigzag(uint64_t value) {
+         return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+     }
+
+     /** length delimited field as a message */
+     Message message() {
+         auto size = varint();
+         advance(size);
+         return Message(m_ptr - size, size);
+     }
+
+     std::string bytes() {
+         auto sub = message();
+         return std::string(sub.data(), sub.size());
+     }
+
+     /** packed (or single) repeated varint field */
+     std::vector<uint64_t> packed() {
+         std::vector<uint64_t> values;
+         if (m_wire == VARINT) {
+             values.push_back(varint());
+             return values;
+         }
+         auto sub = message();
+         while (sub.m_ptr < sub.m_end) values.push_back(sub.varint());
+         return values;
+     }
+
+     /** packed delta coded zigzag field */
+     std::vector<int64_t> packed_delta() {
+         std::vector<int64_t> values;
+         int64_t last = 0;
+         for (const auto value : packed()) {
+             last += zigzag(value);
+             values.push_back(last);
+         }
+         return values;
+     }
+
+     void skip() {
+         switch (m_wire) {
+             case VARINT: varint(); break;
+             case FIXED64: advance(8); break;
+             case LENGTH_DELIMITED: advance(varint()); break;
+             case FIXED32: advance(4); break;
+             default: throw Format_error("unknown wire type");
+         }
+     }
+
+ private:
+     void advance(uint64_t size) {
+         if (size > static_cast<uint64_t>(m_end - m_ptr)) {
+             throw Format_error("truncated message");
+         }
+         m_ptr += size;
+     }
+
+ private:
+     const char *m_ptr;
+     const char *m_end;
+     uint32_t m_field;
+     uint32_t m_wire;
+};
+
+
+/*
+ * A decoded element event, replayed on the callback
+ */
+struct Event {
+    const char *name;
+    bool start;
+    std::vector<std::string> atts;
+};
+typedef std::vector<Event> Events;
+
+
+/*
+ * coordinates are in nanodegrees
+ * written with 7 decimals (the OSM precision) unless more are needed
+ *   45000000000  -> "45.0000000"
+ *   45112345678  -> "45.112345678"
+ */
+std::string
+coordinate_str(int64_t nanodegrees) {
+    auto value = nanodegrees < 0 ?
+        static_cast<uint64_t>(-(nanodegrees + 1)) + 1
+        : static_cast<uint64_t>(nanodegrees);
+    auto fraction = value % 1000000000;
+
+    char buf[32];
+    if (fraction % 100 == 0) {
+        snprintf(buf, sizeof(buf), "%s%llu.%07llu",
+                nanodegrees < 0 ? "-" : "",
+                static_cast<unsigned long long>(value / 1000000000),
+                static_cast<unsigned long long>(fraction / 100));
+    } else {
+        snprintf(buf, sizeof(buf), "%s%llu.%09llu",
+                nanodegrees < 0 ? "-" : "",
+                static_cast<unsigned long long>(value / 1000000000),
+                static_cast<unsigned long long>(fraction));
+    }
+    return buf;
+}
+
+std::string
+timestamp_str(int64_t milliseconds) {
+    time_t seconds = static_cast<time_t>(milliseconds / 1000);
+    struct tm tm;
+    char buf[32];
+    gmtime_r(&seconds, &tm);
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return buf;
+}
+
+
+/** @brief decodes a PrimitiveBlock into element events
+ *
+ * https://wiki.openstreetmap.org/wiki/PBF_Format#Encoding_OSM_entities_into_fileblocks
+ */
+class Block_decoder {
+ public:
+     Block_decoder() :
+         m_granularity(100),
+         m_lat_offset(0),
+         m_lon_offset(0),
+         m_date_granularity(1000) {}
+
+     Events decode(const std::string &raw) {
+         std::vector<Message> groups;
+         Message block(raw);
+         while (block.next()) {
+             switch (block.field()) {
+                 case 1: string_table(block.message()); break;
+                 case 2: groups.push_back(block.message()); break;
+                 case 17: m_granularity = static_cast<int64_t>(block.varint()); break;
+                 case 18: m_date_granularity = static_cast<int64_t>(block.varint()); break;
+                 case 19: m_lat_offset = static_cast<int64_t>(block.varint()); break;
+                 case 20: m_lon_offset = static_cast<int64_t>(block.varint()); break;
+                 default: block.skip();
+             }
+         }
+
+         for (auto &group : groups) {
+             while (group.next()) {
+                 switch (group.field()) {
+                     case 1: node(group.message()); break;
+                     case 2: dense_nodes(group.message()); break;
+                     case 3: way(group.message()); break;
+                     case 4: relation(group.message()); break;
+                     default: group.skip();
+                 }
+             }
+         }
+         return std::move(m_events);
+     }
+
+ private:
+     void string_table(Message table) {
+         while (table.next()) {
+             if (table.field() == 1) {
+                 m_strings.push_back(table.bytes());
+             } else {
+                 table.skip();
+             }
+         }
+     }
+
+     const std::string& str(uint64_t index) const {
+         if (index >= m_strings.size()) throw Format_error("string index out of range");
+         return m_strings[index];
+     }
+
+     inline std::string lat_str(int64_t lat) const {
+         return coordinate_str(m_lat_offset + m_granularity * lat);
+     }
+
+     inline std::string lon_str(int64_t lon) const {
+         return coordinate_str(m_lon_offset + m_granularity * lon);
+     }
+
+     inline std::string time_str(int64_t timestamp) const {
+         return timestamp_str(timestamp * m_date_granularity);
+     }
+
+     void start(const char *name, std::vector<std::string> &atts) {
+         m_events.push_back(Event{name, true, std::move(atts)});
+     }
+
+     void end(const char *name) {
+         m_events.push_back(Event{name, false, std::vector<std::string>()});
+     }
+
+     void tags(const std::vector<uint64_t> &keys, const std::vector<uint64_t> &vals) {
+         if (keys.size() != vals.size()) throw Format_error("keys and values do not match");
+         for (size_t i = 0; i < keys.size(); ++i) {
+             std::vector<std::string> atts {"k", str(keys[i]), "v", str(vals[i])};
+             start("tag", atts);
+             end("tag");
+         }
+     }
+
+     /*
+      * Info message of nodes, ways & relations
+      */
+     void info(Message info, std::vector<std::string> &atts) const {
+         while (info.next()) {
+             switch (info.field()) {
+                 case 1:
+                     atts.push_back("version");
+                     atts.push_back(std::to_string(static_cast<int32_t>(info.varint())));
+                     break;
+                 case 2:
+                     atts.push_back("timestamp");
+                     atts.push_back(time_str(static_cast<int64_t>(info.varint())));
+                     break;
+                 case 3:
+                     atts.push_back("changeset");
+                     atts.push_back(std::to_string(static_cast<int64_t>(info.varint())));
+                     break;
+                 case 4:
+                     atts.push_back("uid");
+                     atts.push_back(std::to_string(static_cast<int32_t>(info.varint())));
+                     break;
+                 case 5:
+                     atts.push_back("user");
+                     atts.push_back(str(info.varint()));
+                     break;
+                 case 6:
+                     atts.push_back("visible");
+                     atts.push_back(info.varint() ? "true" : "false");
+                     break;
+                 default: info.skip();
+             }
+         }
+     }
+
+     void node(Message node) {
+         int64_t id(0), lat(0), lon(0);
+         std::vector<uint64_t> keys, vals;
+         std::vector<std::string> atts;
+         while (node.next()) {
+             switch (node.field()) {
+                 case 1: id = node.svarint(); break;
+                 case 2: keys = node.packed(); break;
+                 case 3: vals = node.packed(); break;
+                 case 4: info(node.message(), atts); break;
+                 case 8: lat = node.svarint(); break;
+                 case 9: lon = node.svarint(); break;
+                 default: node.skip();
+             }
+         }
+         atts.insert(atts.begin(), {"id", std::to_string(id)});
+         atts.insert(atts.end(), {"lat", lat_str(lat), "lon", lon_str(lon)});
+         start("node", atts);
+         tags(keys, vals);
+         end("node");
+     }
+
+     void dense_nodes(Message dense) {
+         std::vector<int64_t> ids, lats, lons;
+         std::vector<uint64_t> keys_vals;
+         std::vector<uint64_t> versions, visibles;
+         std::vector<int64_t> timestamps, changesets, uids, user_sids;
+         while (dense.next()) {
+             switch (dense.field()) {
+                 case 1: ids = dense.packed_delta(); break;
+                 case 5: {
+                     auto info = dense.message();
+                     while (info.next()) {
+                         switch (info.field()) {
+                             case 1: versions = info.packed(); break;
+                             case 2: timestamps = info.packed_delta(); break;
+                             case 3: changesets = info.packed_delta(); break;
+                             case 4: uids = info.packed_delta(); break;
+                             case 5: user_sids = info.packed_delta(); break;
+                             case 6: visibles = info.packed(); break;
+                             default: info.skip();
+                         }
+                     }
+                     break;
+                 }
+                 case 8: lats = dense.packed_delta(); break;
+                 case 9: lons = dense.packed_delta(); break;
+                 case 10: keys_vals = dense.packed(); break;
+                 default: dense.skip();
+             }
+         }
+         if (lats.size() != ids.size() || lons.size() != ids.size()) {
+             throw Format_error("dense nodes: coordinates do not match the ids");
+         }
+
+         size_t kv = 0;
+         for (size_t i = 0; i < ids.size(); ++i) {
+             std::vector<std::string> atts {"id", std::to_string(ids[i])};
+             if (i < versions.size()) {
+                 atts.insert(atts.end(), {"version", std::to_string(static_cast<int32_t>(versions[i]))});
+             }
+             if (i < timestamps.size()) {
+                 atts.insert(atts.end(), {"timestamp", time_str(timestamps[i])});
+             }
+             if (i < changesets.size()) {
+                 atts.insert(atts.end(), {"changeset", std::to_string(changesets[i])});
+             }
+             if (i < uids.size()) {
+                 atts.insert(atts.end(), {"uid", std::to_string(uids[i])});
+             }
+             if (i < user_sids.size()) {
+                 atts.insert(atts.end(), {"user", str(static_cast<uint64_t>(user_sids[i]))});
+             }
+             if (i < visibles.size()) {
+                 atts.insert(atts.end(), {"visible", visibles[i] ? "true" : "false"});
+             }
+             atts.insert(atts.end(), {"lat", lat_str(lats[i]), "lon", lon_str(lons[i])});
+             start("node", atts);
+
+             /*
+              * keys_vals: ((k v)* 0)* when any node of the block has tags
+              */
+             while (kv < keys_vals.size() && keys_vals[kv] != 0) {
+                 if (kv + 1 >= keys_vals.size()) throw Format_error("dense nodes: key without value");
+                 std::vector<std::string> tag {"k", str(keys_vals[kv]), "v", str(keys_vals[kv + 1])};
+                 start("tag", tag);
+                 end("tag");
+                 kv += 2;
+             }
+             ++kv;
+             end("node");
+         }
+     }
+
+     void way(Message way) {
+         int64_t id(0);
+         std::vector<uint64_t> keys, vals;
+         std::vector<int64_t> refs;
+         std::vector<std::string> atts;
+         while (way.next()) {
+             switch (way.field()) {
+                 case 1: id = static_cast<int64_t>(way.varint()); break;
+                 case 2: keys = way.packed(); break;
+                 case 3: vals = way.packed(); break;
+                 case 4: info(way.message(), atts); break;
+                 case 8: refs = way.packed_delta(); break;
+                 default: way.skip();
+             }
+         }
+         atts.insert(atts.begin(), {"id", std::to_string(id)});
+         start("way", atts);
+         for (const auto ref : refs) {
+             std::vector<std::string> nd {"ref", std::to_string(ref)};
+             start("nd", nd);
+             end("nd");
+         }
+         tags(keys, vals);
+         end("way");
+     }
+
+     void relation(Message relation) {
+         static const char* member_types[] = {"node", "way", "relation"};
+         int64_t id(0);
+         std::vector<uint64_t> keys, vals, roles, types;
+         std::vector<int64_t> memids;
+         std::vector<std::string> atts;
+         while (relation.next()) {
+             switch (relation.field()) {
+                 case 1: id = static_cast<int64_t>(relation.varint()); break;
+                 case 2: keys = relation.packed(); break;
+                 case 3: vals = relation.packed(); break;
+                 case 4: info(relation.message(), atts); break;
+                 case 8: roles = relation.packed(); break;
+                 case 9: memids = relation.packed_delta(); break;
+                 case 10: types = relation.packed(); break;
+                 default: relation.skip();
+             }
+         }
+         if (roles.size() != memids.size() || types.size() != memids.size()) {
+             throw Format_error("relation: members do not match");
+         }
+         atts.insert(atts.begin(), {"id", std::to_string(id)});
+         start("relation", atts);
+         for (size_t i = 0; i < memids.size(); ++i) {
+             if (types[i] > 2) throw Format_error("relation: unknown member type");
+             std::vector<std::string> member {
+                 "type", member_types[types[i]],
+                 "ref", std::to_string(memids[i]),
+                 "role", str(roles[i])};
+             start("member", member);
+             end("member");
+         }
+         tags(keys, vals);
+         end("relation");
+     }
+
+ private:
+     std::vector<std::string> m_strings;
+     int64_t m_granularity;
+     int64_t m_lat_offset;
+     int64_t m_lon_offset;
+     int64_t m_date_granularity;
+     Events m_events;
+};
+
+
+/*
+ * Blob: the (compressed) contents of a file block
+ */
+std::string
+blob_data(const std::string &blob) {
+    Message message(blob);
+    std::string raw;
+    const char *zlib_data(nullptr);
+    size_t zlib_size(0);
+    size_t raw_size(0);
+
+    while (message.next()) {
+        switch (message.field()) {
+            case 1: raw = message.bytes(); break;
+            case 2: raw_size = static_cast<size_t>(message.varint()); break;
+            case 3: {
+                auto zlib = message.message();
+                zlib_data = zlib.data();
+                zlib_size = zlib.size();
+                break;
+            }
+            case 4: throw Format_error("lzma compressed blobs are not supported");
+            case 5: throw Format_error("bzip2 compressed blobs are not supported");
+            case 6: throw Format_error("lz4 compressed blobs are not supported");
+            case 7: throw Format_error("zstd compressed blobs are not supported");
+            default: message.skip();
+        }
+    }
+    if (!zlib_data) return raw;
+
+    if (raw_size > static_cast<size_t>(MAX_BLOB_SIZE)) throw Format_error("blob too big");
+    std::string data(raw_size, '\0');
+    uLongf length = static_cast<uLongf>(raw_size);
+    if (uncompress(
+                reinterpret_cast<Bytef*>(&data[0]), &length,
+                reinterpret_cast<const Bytef*>(zlib_data), static_cast<uLong>(zlib_size)) != Z_OK
+            || length != raw_size) {
+        throw Format_error("failed to uncompress blob");
+    }
+    return data;
+}
+
+
+/*
+ * OSMHeader: only the features this reader handles are accepted
+ *
+ * returns the writing program
+ */
+std::string
+decode_header(const std::string &raw) {
+    Message header(raw);
+    std::string program;
+    while (header.next()) {
+        switch (header.field()) {
+            case 4: {
+                auto feature = header.bytes();
+                if (feature != "OsmSchema-V0.6" && feature != "DenseNodes") {
+                    throw Format_error("required feature not supported: " + feature);
+                }
+                break;
+            }
+            case 16: program = header.bytes(); break;
+            default: header.skip();
+        }
+    }
+    return program;
+}
+
+
+/*
+ * reads the next BlobHeader & Blob of the file
+ *
+ * returns false at end of file
+ */
+bool
+read_blob(FILE *fp, std::string &type, std::string &blob) {
+    unsigned char size_buf[4];
+    auto n = fread(size_buf, 1, 4, fp);
+    if (n == 0 && feof(fp)) return false;
+    if (n != 4) throw Format_error("truncated blob header size");
+
+    uint32_t header_size =
+        (static_cast<uint32_t>(size_buf[0]) << 24)
+        | (static_cast<uint32_t>(size_buf[1]) << 16)
+        | (static_cast<uint32_t>(size_buf[2]) << 8)
+        | static_cast<uint32_t>(size_buf[3]);
+    if (header_size > MAX_BLOB_HEADER_SIZE) throw Format_error("blob header too big");
+
+    std::string header_data(header_size, '\0');
+    if (fread(&header_data[0], 1, header_size, fp) != header_size) {
+        throw Format_error("truncated blob header");
+    }
+
+    int64_t data_size(-1);
+    Message header(header_data);
+    type.clear();
+    while (header.next()) {
+        switch (header.field()) {
+            case 1: type = header.bytes(); break;
+            case 3: data_size = static_cast<int32_t>(header.varint()); break;
+            default: header.skip();
+        }
+    }
+    if (data_size < 0 || data_size > MAX_BLOB_SIZE) throw Format_error("invalid blob size");
+
+    blob.resize(static_cast<size_t>(data_size));
+    if (fread(&blob[0], 1, blob.size(), fp) != blob.size()) {
+        throw Format_error("truncated blob");
+    }
+    return true;
+}
+
+
+void
+replay(const Events &events, xml::XMLParserCallback &rCallback) {
+    std::vector<const char*> atts;
+    for (const auto &event : events) {
+        if (!event.start) {
+            rCallback.EndElement(event.name);
+            continue;
+        }
+        atts.clear();
+        for (const auto &att : event.atts) atts.push_back(att.c_str());
+        atts.push_back(nullptr);
+        rCallback.StartElement(event.name, atts.data());
+    }
+}
+
+}  // namespace
+
+
+PBFParser::PBFParser(size_t threads) :
+    m_threads(threads ? threads : std::thread::hardware_concurrency()) {
+}
+
+
+bool
+PBFParser::is_pbf(const std::string &file_name) {
+    const std::string extension(".pbf");
+    return file_name.size() > extension.size()
+        && file_name.compare(
+                file_name.size() - extension.size(),
+                extension.size(), extension) == 0;
+}
+
+
+int
+PBFParser::Parse(xml::XMLParserCallback& rCallback, const char* chFileName) {
+    std::unique_ptr<FILE, decltype(&fclose)> fp(fopen(chFileName, "rb"), &fclose);
+    if (!fp) {
+        std::cerr <<  "Error opening " << chFileName << ":" << strerror(errno);
+        return 1;  // File not found
+    }
+
+    int ret = 0;
+    try {
+        /*
+         * on every exit of the block the pending blocks are dropped first,
+         * then the pool is joined: its tasks only hold their own blob
+         */
+        Thread_pool pool(m_threads);
+        /*
+         * blocks being decoded, in file order
+         * at most two per thread are kept in memory
+         */
+        std::deque<std::future<Events>> pending;
+        bool started(false);
+        std::string type;
+        std::string blob;
+
+        while (read_blob(fp.get(), type, blob)) {
+            if (type == "OSMHeader") {
+                auto program = decode_header(blob_data(blob));
+                if (!started) {
+                    std::vector<std::string> atts {"version", "0.6", "generator", program};
+                    replay(Events{Event{"osm", true, atts}}, rCallback);
+                    started = true;
+                }
+                continue;
+            }
+            /* unknown blob types are skipped */
+            if (type != "OSMData") continue;
+            if (!started) throw Format_error("OSMData found before OSMHeader");
+
+            auto data = std::make_shared<std::string>(std::move(blob));
+            pending.push_back(pool.submit([data]() {
+                        return Block_decoder().decode(blob_data(*data));
+                        }));
+
+            while (pending.size() > 2 * pool.size()) {
+                replay(pending.front().get(), rCallback);
+                pending.pop_front();
+            }
+        }
+
+        while (!pending.empty()) {
+            replay(pending.front().get(), rCallback);
+            pending.pop_front();
+        }
+        if (started) rCallback.EndElement("osm");
+    } catch (const Format_error &e) {
+        std::cerr << "PBF error: " << e.what() << " in " << chFileName;
+        ret = 2;  // parsing error
+    } catch (const std::exception &e) {
+        /*
+         * thrown by a decoding task or by the callback
+         */
+        std::cerr << "Error: " << e.what() << " while reading " << chFileName;
+        ret = 2;
+    }
+
+    return ret;
+}
+
+}  // end namespace pbf
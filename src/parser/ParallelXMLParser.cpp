@@ -0,0 +1,371 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+#include "parser/ParallelXMLParser.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WITH_MMAP
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef WITH_MMAP
+#include <sys/mman.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "parser/XMLParser.h"
+#include "parser/Decompressor.h"
+#include "parser/OSMDocumentParserCallback.h"
+#include "osm_elements/OSMDocument.h"
+#include "osm_elements/Node.h"
+#include "osm_elements/Way.h"
+#include "osm_elements/osm_tag.h"
+#include "utilities/thread_pool.h"
+#include "utilities/print_progress.h"
+
+
+namespace osm2pgr {
+
+namespace {
+
+/*
+ * the top level elements of an OSM file, in the order they appear
+ */
+enum Kind {NODE, WAY, RELATION, NONE};
+
+
+bool
+starts_with(const char *p, const char *end, const char *name) {
+    auto len = strlen(name);
+    if (static_cast<size_t>(end - p) <= len) return false;
+    if (memcmp(p, name, len) != 0) return false;
+    auto c = p[len];
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '/' || c == '>';
+}
+
+
+/*
+ * start of the first node, way or relation at or after @b from
+ * @b end when there is none
+ *
+ * A '<' can not be part of an attribute value (it is written &lt;)
+ * so every '<node ' of the file starts a node element.
+ */
+size_t
+next_element(const char *data, size_t from, size_t end, Kind &kind) {
+    const char *last = data + end;
+    const char *p = data + from;
+    while (p < last) {
+        p = static_cast<const char*>(memchr(p, '<', static_cast<size_t>(last - p)));
+        if (!p) break;
+        if (starts_with(p + 1, last, "node")) {kind = NODE; return static_cast<size_t>(p - data);}
+        if (starts_with(p + 1, last, "way")) {kind = WAY; return static_cast<size_t>(p - data);}
+        if (starts_with(p + 1, last, "relation")) {kind = RELATION; return static_cast<size_t>(p - data);}
+        ++p;
+    }
+    kind = NONE;
+    return end;
+}
+
+
+/*
+ * start of the first element of @b kind (or of a later kind)
+ *
+ * the elements are sorted, so a binary search finds
+ * the section without reading the file up to it
+ */
+size_t
+section_start(const char *data, size_t from, size_t end, Kind kind) {
+    Kind found;
+    size_t lo = from;
+    size_t hi = end;
+    while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        next_element(data, mid, end, found);
+        if (found >= kind) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return next_element(data, lo, end, found);
+}
+
+
+/*
+ * the nodes or the ways of a slice
+ */
+struct Slice {
+    Slice() : ok(false) {}
+    OSMDocument::Nodes nodes;
+    OSMDocument::Ways ways;
+    bool ok;
+};
+
+
+/*
+ * Same element handling as OSMDocumentParserCallback
+ * but the elements are kept in the slice:
+ * the document is only read (the nodes of the ways are
+ * found once the slice is parsed, find_nodes does not modify it)
+ */
+class Slice_callback : public xml::XMLParserCallback {
+ public:
+     Slice_callback(OSMDocument &document, Kind kind, Slice &slice) :
+         m_document(document),
+         m_kind(kind),
+         m_slice(slice),
+         m_current(NONE) {}
+
+     virtual void StartElement(const char *name, const char** atts) {
+         if (m_kind == NODE && strcmp(name, "node") == 0) {
+             m_slice.nodes.emplace_back(atts);
+             m_current = NODE;
+             return;
+         }
+         if (m_kind == WAY && strcmp(name, "way") == 0) {
+             m_slice.ways.emplace_back(atts);
+             m_current = WAY;
+             return;
+         }
+
+         if (m_current == NODE && strcmp(name, "tag") == 0) {
+             auto &node = m_slice.nodes.back();
+             auto tag = node.add_tag(Tag(atts));
+             m_document.add_config(&node, tag);
+         }
+         if (m_current == WAY && strcmp(name, "tag") == 0) {
+             auto &way = m_slice.ways.back();
+             auto tag = way.add_tag(Tag(atts));
+             m_document.add_config(&way, tag);
+         }
+         if (m_current == WAY && strcmp(name, "nd") == 0) {
+             m_document.add_node(m_slice.ways.back(), atts);
+         }
+     }
+
+     virtual void EndElement(const char *name) {
+         if (strcmp(name, "node") == 0 || strcmp(name, "way") == 0) {
+             m_current = NONE;
+         }
+     }
+
+ private:
+     OSMDocument &m_document;
+     Kind m_kind;
+     Slice &m_slice;
+     Kind m_current;
+};
+
+
+/*
+ * a regular file mapped in memory
+ */
+struct Mapped_file {
+    Mapped_file() : data(nullptr), size(0) {}
+    ~Mapped_file() {
+#ifdef WITH_MMAP
+        if (data) munmap(const_cast<char*>(data), size);
+#endif
+    }
+    bool map(FILE *fp) {
+#ifdef WITH_MMAP
+        struct stat st;
+        if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) return false;
+        auto addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+        if (addr == MAP_FAILED) return false;
+        data = static_cast<const char*>(addr);
+        size = static_cast<size_t>(st.st_size);
+        madvise(addr, size, MADV_SEQUENTIAL);
+        return true;
+#else
+        (void)fp;
+        return false;
+#endif
+    }
+
+    const char *data;
+    size_t size;
+};
+
+}  // namespace
+
+
+ParallelXMLParser::ParallelXMLParser(
+        OSMDocument &document,
+        size_t threads,
+        size_t read_size) :
+    m_document(document),
+    m_threads(threads ? threads : std::thread::hardware_concurrency()),
+    m_read_size(read_size),
+    m_bytes(0),
+    m_seconds(0) {
+        if (m_threads == 0) m_threads = 1;
+    }
+
+
+double
+ParallelXMLParser::throughput() const {
+    if (m_seconds <= 0) return 0;
+    return static_cast<double>(m_bytes) / (1024 * 1024) / m_seconds;
+}
+
+
+int
+ParallelXMLParser::Parse(const char* chFileName) {
+    m_bytes = 0;
+    m_seconds = 0;
+
+    FILE* fp = fopen(chFileName, "rb");
+    if (!fp) {
+        std::cerr <<  "Error opening " << chFileName << ":" << strerror(errno);
+        return 1;  // File not found
+    }
+
+    Mapped_file file;
+    if (xml::Decompressor::format(fp) != xml::Decompressor::NONE || !file.map(fp)) {
+        /*
+         * a single parser reads the file
+         */
+        fclose(fp);
+        xml::XMLParser parser(m_read_size, true);
+        OSMDocumentParserCallback callback(m_document);
+        auto ret = parser.Parse(callback, chFileName);
+        m_bytes = parser.bytes();
+        m_seconds = parser.seconds();
+        return ret;
+    }
+    fclose(fp);
+
+    auto start = std::chrono::steady_clock::now();
+    auto ok = parse_mapped(file.data, file.size);
+    m_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    m_bytes = file.size;
+
+    return ok ? 0 : 2;
+}
+
+
+bool
+ParallelXMLParser::parse_mapped(const char *data, size_t size) {
+    /*
+     * the document ends with </osm>
+     */
+    auto osm_end = size;
+    while (osm_end > 0
+            && !(osm_end + 5 <= size && memcmp(data + osm_end, "</osm", 5) == 0)) {
+        --osm_end;
+    }
+    if (!(osm_end + 5 <= size && memcmp(data + osm_end, "</osm", 5) == 0)) {
+        std::cerr << "The document has no </osm> at the end\n";
+        return false;
+    }
+
+    Kind kind;
+    auto nodes_begin = next_element(data, 0, osm_end, kind);
+    auto ways_begin = section_start(data, nodes_begin, osm_end, WAY);
+    auto relations_begin = section_start(data, ways_begin, osm_end, RELATION);
+
+    auto start = std::chrono::steady_clock::now();
+    auto last_report = start;
+    auto progress = [&](size_t offset, bool done) {
+        auto now = std::chrono::steady_clock::now();
+        if (!done && now - last_report < std::chrono::seconds(1)) return;
+        last_report = now;
+        print_read_progress(size, offset, std::chrono::duration<double>(now - start).count());
+        if (done) std::cout << "\n";
+    };
+
+    Thread_pool pool(m_threads);
+
+    /*
+     * the slices of a section are parsed concurrently
+     * and added to the document in order
+     */
+    auto parse_section = [&](size_t begin, size_t end, Kind section) {
+        if (begin >= end) return true;
+        auto slice_size = std::max(
+                static_cast<size_t>(64 * 1024),
+                std::min(m_read_size, (end - begin) / pool.size() + 1));
+
+        std::deque<std::pair<std::future<Slice>, size_t>> pending;
+        auto from = begin;
+        while (from < end || !pending.empty()) {
+            while (from < end && pending.size() < 2 * pool.size()) {
+                Kind found;
+                auto to = from + slice_size < end ?
+                    next_element(data, from + slice_size, end, found) : end;
+                auto &document = m_document;
+                pending.emplace_back(pool.submit([data, from, to, section, &document] {
+                            Slice slice;
+                            Slice_callback callback(document, section, slice);
+                            xml::XMLParser parser;
+                            slice.ok = parser.ParseSlice(callback, data + from, to - from, "osm");
+                            document.find_nodes(slice.ways.begin(), slice.ways.end());
+                            return slice;
+                            }), to);
+                from = to;
+            }
+
+            auto slice = pending.front().first.get();
+            auto slice_end = pending.front().second;
+            pending.pop_front();
+            if (!slice.ok) return false;
+
+            for (const auto &node : slice.nodes) {
+                m_document.AddNode(node);
+            }
+            for (auto &way : slice.ways) {
+                m_document.use_nodes(way);
+                m_document.AddWay(way);
+            }
+            progress(slice_end, false);
+        }
+        return true;
+    };
+
+    if (!parse_section(nodes_begin, ways_begin, NODE)) return false;
+    m_document.endOfNodes();
+    if (!parse_section(ways_begin, relations_begin, WAY)) return false;
+
+    /*
+     * the relations modify the ways in file order,
+     * the end of the nodes is already done
+     */
+    xml::XMLParser parser(m_read_size);
+    OSMDocumentParserCallback callback(m_document, true);
+    if (!parser.ParseSlice(callback, data + relations_begin, osm_end - relations_begin, "osm")) {
+        return false;
+    }
+    progress(size, true);
+    return true;
+}
+
+}  // end namespace osm2pgr
@@ -0,0 +1,123 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+#include "parser/RoutableScanCallback.h"
+
+#include <boost/lexical_cast.hpp>
+#include <string>
+#include "configuration/configuration.h"
+#include "osm_elements/osm_tag.h"
+
+
+namespace osm2pgr {
+
+/*
+ * value of the attribute @b key, nullptr when missing
+ */
+static
+const char*
+attribute(const char **atts, const char *key) {
+    for (auto **attribut = atts; *attribut != NULL; attribut += 2) {
+        if (strcmp(attribut[0], key) == 0) return attribut[1];
+    }
+    return nullptr;
+}
+
+
+void
+RoutableScanCallback::StartElement(
+        const char *name,
+        const char** atts) {
+    if (strcmp(name, "way") == 0) {
+        auto id = attribute(atts, "id");
+        m_way_id = id ? boost::lexical_cast<int64_t>(id) : 0;
+        m_in_way = true;
+        m_routable = false;
+        m_refs.clear();
+        return;
+    }
+
+    if (m_in_way) {
+        if (strcmp(name, "nd") == 0) {
+            /*
+             * same reading as OSMDocument::add_node
+             */
+            m_refs.push_back(atts[0] && strcmp(atts[0], "ref") == 0 ?
+                    boost::lexical_cast<int64_t>(atts[1]) : -1);
+        }
+        if (!m_members_pass && !m_routable && strcmp(name, "tag") == 0) {
+            m_routable = m_config.has_tag(Tag(atts));
+        }
+        return;
+    }
+
+    if (m_members_pass) return;
+
+    if (strcmp(name, "relation") == 0) {
+        m_in_relation = true;
+        m_routable = false;
+        m_refs.clear();
+        return;
+    }
+
+    if (m_in_relation) {
+        if (strcmp(name, "member") == 0) {
+            /*
+             * same reading as Relation::add_member
+             */
+            auto type = attribute(atts, "type");
+            auto ref = attribute(atts, "ref");
+            if (type && strcmp(type, "way") != 0) return;
+            m_refs.push_back(ref ? boost::lexical_cast<int64_t>(ref) : 0);
+        }
+        if (!m_routable && strcmp(name, "tag") == 0) {
+            m_routable = m_config.has_tag(Tag(atts));
+        }
+    }
+}
+
+
+void
+RoutableScanCallback::EndElement(const char* name) {
+    if (m_in_way && strcmp(name, "way") == 0) {
+        m_in_way = false;
+        if (m_members_pass) {
+            m_routable = m_member_ways.test(m_way_id);
+        } else if (m_routable) {
+            m_ways.set(m_way_id);
+        }
+        if (m_routable) {
+            for (const auto id : m_refs) m_nodes.set(id);
+        }
+        return;
+    }
+
+    if (m_in_relation && strcmp(name, "relation") == 0) {
+        m_in_relation = false;
+        if (!m_routable) return;
+        for (const auto id : m_refs) {
+            if (m_ways.test(id)) continue;
+            m_ways.set(id);
+            m_member_ways.set(id);
+            m_members_pending = true;
+        }
+    }
+}
+
+}  // end namespace osm2pgr
@@ -23,68 +23,224 @@
 
 #include <errno.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <iostream>
 #include <cstdio>
+#include <vector>
+
+#include "utilities/print_progress.h"
 
 
 
 namespace xml {
 
-//------------------------------------- global Expat Callbacks:
+/*
+ * elements parsed between looks at the clock
+ */
+static const size_t PROGRESS_ELEMENTS = 64 * 1024;
+
+//------------------------------------- Expat Callbacks:
+
+void XMLCALL
+XMLParser::startElement(void *userData, const char *name, const char **atts) {
+    XMLParser* parser = reinterpret_cast<XMLParser*>(userData);
+    parser->m_callback->StartElement(name, atts);
+    if (parser->m_show_progress
+            && (++parser->m_elements % PROGRESS_ELEMENTS) == 0) {
+        parser->show_progress(false);
+    }
+}
+
+void XMLCALL
+XMLParser::endElement(void *userData, const char *name) {
+    XMLParser* parser = reinterpret_cast<XMLParser*>(userData);
+    parser->m_callback->EndElement(name);
+}
+
 
-static void startElement(void *userData, const char *name, const char **atts) {
-    XMLParserCallback* pCallback =
-        reinterpret_cast<XMLParserCallback*>(userData);
-    if (pCallback) pCallback->StartElement(name, atts);
+size_t
+XMLParser::position() const {
+    if (m_decompressor) return m_decompressor->compressed_bytes();
+    auto index = XML_GetCurrentByteIndex(m_ParserCtxt);
+    return index > 0 ? static_cast<size_t>(index) : 0;
 }
 
-static void endElement(void *userData, const char *name) {
-    XMLParserCallback* pCallback =
-        reinterpret_cast<XMLParserCallback*>(userData);
-    if (pCallback) pCallback->EndElement(name);
+
+/*
+ * at most one report per second
+ */
+void
+XMLParser::show_progress(bool done) {
+    auto now = std::chrono::steady_clock::now();
+    if (!done && now - m_last_report < std::chrono::seconds(1)) return;
+    m_last_report = now;
+
+    auto read = done ? m_file_size : position();
+    print_read_progress(
+            m_file_size,
+            read,
+            std::chrono::duration<double>(now - m_start).count());
+    if (done) std::cout << "\n";
 }
 
 
 
+double
+XMLParser::throughput() const {
+    if (m_seconds <= 0) return 0;
+    return static_cast<double>(m_bytes) / (1024 * 1024) / m_seconds;
+}
+
 
 int XMLParser::Parse(XMLParserCallback& rCallback, const char* chFileName) {
-  int ret = 1;  // File not found
+  m_bytes = 0;
+  m_seconds = 0;
+  m_callback = &rCallback;
+  m_decompressor = nullptr;
+  m_file_size = 0;
+  m_elements = 0;
 
   FILE* fp = fopen(chFileName, "rb");
-  if (fp) {
-    XML_Parser parser = XML_ParserCreate(NULL);
+  if (!fp) {
+      std::cerr <<  "Error opening " << chFileName << ":" << strerror(errno);
+      return 1;  // File not found
+  }
+  /*
+   * setvbuf is only valid before any I/O on the stream:
+   * the reads are large blocks, a stdio buffer would be one more copy
+   */
+  setvbuf(fp, nullptr, _IONBF, 0);
+  m_start = m_last_report = std::chrono::steady_clock::now();
+
+  struct stat st;
+  if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode)) {
+      m_file_size = static_cast<size_t>(st.st_size);
+  }
 
-    XML_SetUserData(parser, static_cast<void*>(&rCallback));
+  m_ParserCtxt = XML_ParserCreate(NULL);
+  XML_SetUserData(m_ParserCtxt, static_cast<void*>(this));
 
-    // register Callbacks for start- and end-element events of the parser:
-    XML_SetElementHandler(parser, startElement, endElement);
+  // register Callbacks for start- and end-element events of the parser:
+  XML_SetElementHandler(m_ParserCtxt, startElement, endElement);
 
-    int done;
-    do {  // loop over whole file content
-      char buf[BUFSIZ];
-      size_t len = fread(buf, 1, sizeof(buf), fp);    // read chunk of data
-      // end of file reached if buffer not completely filled
-      done = len < sizeof(buf);
-      if (!XML_Parse(parser, buf, static_cast<int>(len), done)) {
-        // a parse error occurred:
-          std::cerr <<
-            XML_ErrorString(XML_GetErrorCode(parser))
-            << " at line "
-            << static_cast<int>(XML_GetCurrentLineNumber(parser));
-        fclose(fp);
-        ret = 2;    // quit, return = 2 indicating parsing error
-        done = 1;
-        return ret;
+  bool ok(false);
+  bool parsed(false);
+  auto compression = Decompressor::format(fp);
+  if (compression != Decompressor::NONE) {
+      parsed = true;
+      ok = parse_compressed(fp, compression);
+      m_decompressor = nullptr;
+  }
+  if (!parsed) ok = parse_stream(fp);
+
+  if (ok && m_show_progress) show_progress(true);
+
+  XML_ParserFree(m_ParserCtxt);
+  m_ParserCtxt = nullptr;
+  fclose(fp);
+
+  m_seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - m_start).count();
+
+  return ok ? 0 : 2;  // 2 indicating parsing error
+}
+
+
+bool
+XMLParser::ParseSlice(
+        XMLParserCallback& rCallback,
+        const char *data, size_t size,
+        const std::string &root) {
+  m_callback = &rCallback;
+  m_decompressor = nullptr;
+  m_ParserCtxt = XML_ParserCreate(NULL);
+  XML_SetUserData(m_ParserCtxt, static_cast<void*>(this));
+  XML_SetElementHandler(m_ParserCtxt, startElement, endElement);
+
+  auto start_tag = "<" + root + ">";
+  auto end_tag = "</" + root + ">";
+  auto window = std::min(m_read_size, static_cast<size_t>(INT_MAX));
+
+  bool ok = feed(start_tag.c_str(), start_tag.size(), false);
+  for (size_t offset = 0; ok && offset < size; offset += window) {
+      ok = feed(data + offset, std::min(window, size - offset), false);
+  }
+  ok = ok && feed(end_tag.c_str(), end_tag.size(), true);
+
+  XML_ParserFree(m_ParserCtxt);
+  m_ParserCtxt = nullptr;
+  return ok;
+}
+
+
+/*
+ * the file is read straight into the expat buffer:
+ * XML_GetBuffer gives the buffer, the stream is not buffered (Parse) so the
+ * read is the only copy of the data, XML_ParseBuffer parses it in place
+ */
+bool
+XMLParser::parse_stream(FILE *fp) {
+  auto window = std::min(m_read_size, static_cast<size_t>(INT_MAX));
+
+  bool done;
+  do {  // loop over whole file content
+      auto buf = XML_GetBuffer(m_ParserCtxt, static_cast<int>(window));
+      if (!buf) {
+          std::cerr << "Out of memory for a " << window << " bytes read";
+          return false;
+      }
+      size_t len = fread(buf, 1, window, fp);    // read chunk of data
+      if (ferror(fp)) {
+          std::cerr << "Error reading: " << strerror(errno);
+          return false;
       }
-    } while (!done);
+      // end of file reached if buffer not completely filled
+      done = len < window;
+      if (!feed(nullptr, len, done)) return false;
+  } while (!done);
+  return true;
+}
 
-    XML_ParserFree(parser);
-    fclose(fp);
-    ret = 0;
-  } else {
-      std::cerr <<  "Error opening " << chFileName << ":" << strerror(errno);
+
+/*
+ * the decompressing thread fills the next buffer while expat parses this one
+ */
+bool
+XMLParser::parse_compressed(FILE *fp, Decompressor::Format format) {
+  Decompressor decompressor(fp, format, m_read_size);
+  m_decompressor = &decompressor;
+
+  std::vector<char> buffer;
+  while (decompressor.next(buffer)) {
+      if (!feed(buffer.data(), buffer.size(), false)) return false;
+  }
+  if (!decompressor.error().empty()) {
+      std::cerr << decompressor.error() << "\n";
+      return false;
+  }
+  return feed("", 0, true);
+}
+
+
+bool
+XMLParser::feed(const char *data, size_t len, bool done) {
+  auto status = data ?
+      XML_Parse(m_ParserCtxt, data, static_cast<int>(len), done)
+      : XML_ParseBuffer(m_ParserCtxt, static_cast<int>(len), done);
+
+  if (status == XML_STATUS_ERROR) {
+      // a parse error occurred:
+      std::cerr <<
+          XML_ErrorString(XML_GetErrorCode(m_ParserCtxt))
+          << " at line "
+          << static_cast<int>(XML_GetCurrentLineNumber(m_ParserCtxt));
+      return false;
   }
-  return ret;  // return = 0 indicating success
+  m_bytes += len;
+  return true;
 }
 
 
@@ -0,0 +1,179 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+#include "utilities/geodesic.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+/*
+ * WGS84
+ */
+const double A = 6378137.0;
+const double F = 1 / 298.257223563;
+const double B = A * (1 - F);
+const double E2 = F * (2 - F);
+
+//! radians of 1e-7 degrees
+const double RADIANS = PI / 180 / 1e7;
+
+//! half a turn in units of 1e-7 degrees
+const int64_t HALF_TURN = 1800000000;
+
+/*
+ * difference of longitudes on the shortest side of the antimeridian
+ */
+inline
+int64_t
+delta_lon(int32_t lon1, int32_t lon2) {
+    int64_t delta = int64_t(lon2) - lon1;
+    delta -= delta > HALF_TURN ? 2 * HALF_TURN : 0;
+    delta += delta < -HALF_TURN ? 2 * HALF_TURN : 0;
+    return delta;
+}
+
+/*
+ * sine of a latitude, |x| <= pi / 2
+ *
+ * Taylor series to x^23 (the next term is below 2e-18):
+ * no call, so the loop of segment_lengths is vectorized
+ */
+inline
+double
+sin_latitude(double x) {
+    auto x2 = x * x;
+    auto p = 1.0 / 25852016738884976640000.0;
+    p = 1.0 / 51090942171709440000.0 - x2 * p;
+    p = 1.0 / 121645100408832000.0 - x2 * p;
+    p = 1.0 / 355687428096000.0 - x2 * p;
+    p = 1.0 / 1307674368000.0 - x2 * p;
+    p = 1.0 / 6227020800.0 - x2 * p;
+    p = 1.0 / 39916800.0 - x2 * p;
+    p = 1.0 / 362880.0 - x2 * p;
+    p = 1.0 / 5040.0 - x2 * p;
+    p = 1.0 / 120.0 - x2 * p;
+    p = 1.0 / 6.0 - x2 * p;
+    p = 1.0 - x2 * p;
+    return x * p;
+}
+
+//! segments measured in one call of segment_lengths
+const size_t BLOCK = 256;
+
+}  // namespace
+
+
+/*
+ * the differences of the coordinates are exact in double
+ */
+void
+segment_lengths(const int32_t *lons, const int32_t *lats, size_t n, double *lengths) {
+    for (size_t i = 1; i < n; ++i) {
+        auto lat = (double(lats[i]) + double(lats[i - 1])) * 0.5 * RADIANS;
+        auto dlat = (double(lats[i]) - double(lats[i - 1])) * RADIANS;
+        auto dlon = double(lons[i]) - double(lons[i - 1]);
+        dlon -= dlon > double(HALF_TURN) ? 2 * double(HALF_TURN) : 0;
+        dlon += dlon < -double(HALF_TURN) ? 2 * double(HALF_TURN) : 0;
+        dlon *= RADIANS;
+
+        auto sin_lat = sin_latitude(lat);
+        auto w2 = 1 - E2 * sin_lat * sin_lat;
+        auto w = std::sqrt(w2);
+        /*
+         * prime vertical & meridian radii of curvature,
+         * cos(lat) is not negative
+         */
+        auto n_radius = A / w;
+        auto m_radius = A * (1 - E2) / (w2 * w);
+
+        auto dx = n_radius * std::sqrt(1 - sin_lat * sin_lat) * dlon;
+        auto dy = m_radius * dlat;
+        lengths[i - 1] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+
+double
+vincenty_distance(int32_t lon1, int32_t lat1, int32_t lon2, int32_t lat2) {
+    auto L = double(delta_lon(lon1, lon2)) * RADIANS;
+    auto U1 = std::atan((1 - F) * std::tan(lat1 * RADIANS));
+    auto U2 = std::atan((1 - F) * std::tan(lat2 * RADIANS));
+    auto sin_U1 = std::sin(U1), cos_U1 = std::cos(U1);
+    auto sin_U2 = std::sin(U2), cos_U2 = std::cos(U2);
+
+    auto lambda = L;
+    double sin_sigma = 0, cos_sigma = 1, sigma = 0, cos2_alpha = 1, cos_2sigma_m = 0;
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        auto sin_lambda = std::sin(lambda), cos_lambda = std::cos(lambda);
+        sin_sigma = std::sqrt(
+                (cos_U2 * sin_lambda) * (cos_U2 * sin_lambda)
+                + (cos_U1 * sin_U2 - sin_U1 * cos_U2 * cos_lambda)
+                * (cos_U1 * sin_U2 - sin_U1 * cos_U2 * cos_lambda));
+        if (sin_sigma == 0) return 0;
+        cos_sigma = sin_U1 * sin_U2 + cos_U1 * cos_U2 * cos_lambda;
+        sigma = std::atan2(sin_sigma, cos_sigma);
+        auto sin_alpha = cos_U1 * cos_U2 * sin_lambda / sin_sigma;
+        cos2_alpha = 1 - sin_alpha * sin_alpha;
+        /*
+         * on the equator cos2_alpha is 0
+         */
+        cos_2sigma_m = cos2_alpha != 0 ? cos_sigma - 2 * sin_U1 * sin_U2 / cos2_alpha : 0;
+        auto C = F / 16 * cos2_alpha * (4 + F * (4 - 3 * cos2_alpha));
+        auto previous = lambda;
+        lambda = L + (1 - C) * F * sin_alpha
+            * (sigma + C * sin_sigma * (cos_2sigma_m + C * cos_sigma * (-1 + 2 * cos_2sigma_m * cos_2sigma_m)));
+        if (std::fabs(lambda - previous) < 1e-12) break;
+    }
+
+    auto u2 = cos2_alpha * (A * A - B * B) / (B * B);
+    auto big_a = 1 + u2 / 16384 * (4096 + u2 * (-768 + u2 * (320 - 175 * u2)));
+    auto big_b = u2 / 1024 * (256 + u2 * (-128 + u2 * (74 - 47 * u2)));
+    auto delta_sigma = big_b * sin_sigma
+        * (cos_2sigma_m + big_b / 4
+                * (cos_sigma * (-1 + 2 * cos_2sigma_m * cos_2sigma_m)
+                    - big_b / 6 * cos_2sigma_m * (-3 + 4 * sin_sigma * sin_sigma)
+                    * (-3 + 4 * cos_2sigma_m * cos_2sigma_m)));
+    return B * big_a * (sigma - delta_sigma);
+}
+
+
+/*
+ * the segments are measured in blocks,
+ * the last point of a block is the first point of the next one
+ */
+double
+geodesic_length(const int32_t *lons, const int32_t *lats, size_t n) {
+    double lengths[BLOCK];
+    double length = 0;
+    for (size_t first = 0; first + 1 < n; first += BLOCK) {
+        auto count = std::min(BLOCK + 1, n - first);
+        segment_lengths(lons + first, lats + first, count, lengths);
+        for (size_t i = 0; i + 1 < count; ++i) {
+            length += lengths[i] < GEODESIC_SHORT ?
+                lengths[i]
+                : vincenty_distance(lons[first + i], lats[first + i], lons[first + i + 1], lats[first + i + 1]);
+        }
+    }
+    return length;
+}
@@ -0,0 +1,422 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+#include "utilities/number_format.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+
+/*
+ * digits of @b value ending at @b end, two at a time
+ * returns the first digit
+ */
+char*
+write_digits(uint64_t value, char *end) {
+    auto p = end;
+    while (value >= 100) {
+        auto pair = static_cast<size_t>(value % 100) * 2;
+        value /= 100;
+        *--p = DIGIT_PAIRS[pair + 1];
+        *--p = DIGIT_PAIRS[pair];
+    }
+    if (value >= 10) {
+        auto pair = static_cast<size_t>(value) * 2;
+        *--p = DIGIT_PAIRS[pair + 1];
+        *--p = DIGIT_PAIRS[pair];
+    } else {
+        *--p = static_cast<char>('0' + value);
+    }
+    return p;
+}
+
+
+uint64_t
+magnitude(int64_t value) {
+    return value < 0 ?
+        uint64_t(0) - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+}
+
+
+char*
+copy(const char *begin, const char *end, char *buffer) {
+    auto size = static_cast<size_t>(end - begin);
+    memmove(buffer, begin, size);
+    return buffer + size;
+}
+
+
+/*
+ * Grisu2 (Florian Loitsch, "Printing floating-point numbers quickly
+ * and accurately with integers", PLDI 2010):
+ * the digits always read back as the value,
+ * they are the shortest ones for nearly all the values.
+ */
+
+//! f * 2^e
+struct Diyfp {
+    uint64_t f;
+    int e;
+};
+
+
+Diyfp
+sub(const Diyfp &x, const Diyfp &y) {
+    return {x.f - y.f, x.e};
+}
+
+
+//! rounded upper 64 bits of the product
+Diyfp
+mul(const Diyfp &x, const Diyfp &y) {
+    const uint64_t MASK = 0xFFFFFFFFu;
+    auto u_lo = x.f & MASK;
+    auto u_hi = x.f >> 32;
+    auto v_lo = y.f & MASK;
+    auto v_hi = y.f >> 32;
+
+    auto p0 = u_lo * v_lo;
+    auto p1 = u_lo * v_hi;
+    auto p2 = u_hi * v_lo;
+    auto p3 = u_hi * v_hi;
+
+    auto q = (p0 >> 32) + (p1 & MASK) + (p2 & MASK) + (uint64_t(1) << 31);
+    return {p3 + (p2 >> 32) + (p1 >> 32) + (q >> 32), x.e + y.e + 64};
+}
+
+
+Diyfp
+normalize(Diyfp x) {
+    while ((x.f >> 63) == 0) {
+        x.f <<= 1;
+        --x.e;
+    }
+    return x;
+}
+
+
+//! cached powers of ten: 10^k ~ f * 2^e
+struct Cached_power {
+    uint64_t f;
+    int e;
+    int k;
+};
+
+const Cached_power CACHED_POWERS[] = {
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C, -980, -276},
+    {0xD3515C2831559A83, -954, -268},
+    {0x9D71AC8FADA6C9B5, -927, -260},
+    {0xEA9C227723EE8BCB, -901, -252},
+    {0xAECC49914078536D, -874, -244},
+    {0x823C12795DB6CE57, -847, -236},
+    {0xC21094364DFB5637, -821, -228},
+    {0x9096EA6F3848984F, -794, -220},
+    {0xD77485CB25823AC7, -768, -212},
+    {0xA086CFCD97BF97F4, -741, -204},
+    {0xEF340A98172AACE5, -715, -196},
+    {0xB23867FB2A35B28E, -688, -188},
+    {0x84C8D4DFD2C63F3B, -661, -180},
+    {0xC5DD44271AD3CDBA, -635, -172},
+    {0x936B9FCEBB25C996, -608, -164},
+    {0xDBAC6C247D62A584, -582, -156},
+    {0xA3AB66580D5FDAF6, -555, -148},
+    {0xF3E2F893DEC3F126, -529, -140},
+    {0xB5B5ADA8AAFF80B8, -502, -132},
+    {0x87625F056C7C4A8B, -475, -124},
+    {0xC9BCFF6034C13053, -449, -116},
+    {0x964E858C91BA2655, -422, -108},
+    {0xDFF9772470297EBD, -396, -100},
+    {0xA6DFBD9FB8E5B88F, -369, -92},
+    {0xF8A95FCF88747D94, -343, -84},
+    {0xB94470938FA89BCF, -316, -76},
+    {0x8A08F0F8BF0F156B, -289, -68},
+    {0xCDB02555653131B6, -263, -60},
+    {0x993FE2C6D07B7FAC, -236, -52},
+    {0xE45C10C42A2B3B06, -210, -44},
+    {0xAA242499697392D3, -183, -36},
+    {0xFD87B5F28300CA0E, -157, -28},
+    {0xBCE5086492111AEB, -130, -20},
+    {0x8CBCCC096F5088CC, -103, -12},
+    {0xD1B71758E219652C, -77, -4},
+    {0x9C40000000000000, -50, 4},
+    {0xE8D4A51000000000, -24, 12},
+    {0xAD78EBC5AC620000, 3, 20},
+    {0x813F3978F8940984, 30, 28},
+    {0xC097CE7BC90715B3, 56, 36},
+    {0x8F7E32CE7BEA5C70, 83, 44},
+    {0xD5D238A4ABE98068, 109, 52},
+    {0x9F4F2726179A2245, 136, 60},
+    {0xED63A231D4C4FB27, 162, 68},
+    {0xB0DE65388CC8ADA8, 189, 76},
+    {0x83C7088E1AAB65DB, 216, 84},
+    {0xC45D1DF942711D9A, 242, 92},
+    {0x924D692CA61BE758, 269, 100},
+    {0xDA01EE641A708DEA, 295, 108},
+    {0xA26DA3999AEF774A, 322, 116},
+    {0xF209787BB47D6B85, 348, 124},
+    {0xB454E4A179DD1877, 375, 132},
+    {0x865B86925B9BC5C2, 402, 140},
+    {0xC83553C5C8965D3D, 428, 148},
+    {0x952AB45CFA97A0B3, 455, 156},
+    {0xDE469FBD99A05FE3, 481, 164},
+    {0xA59BC234DB398C25, 508, 172},
+    {0xF6C69A72A3989F5C, 534, 180},
+    {0xB7DCBF5354E9BECE, 561, 188},
+    {0x88FCF317F22241E2, 588, 196},
+    {0xCC20CE9BD35C78A5, 614, 204},
+    {0x98165AF37B2153DF, 641, 212},
+    {0xE2A0B5DC971F303A, 667, 220},
+    {0xA8D9D1535CE3B396, 694, 228},
+    {0xFB9B7CD9A4A7443C, 720, 236},
+    {0xBB764C4CA7A44410, 747, 244},
+    {0x8BAB8EEFB6409C1A, 774, 252},
+    {0xD01FEF10A657842C, 800, 260},
+    {0x9B10A4E5E9913129, 827, 268},
+    {0xE7109BFBA19C0C9D, 853, 276},
+    {0xAC2820D9623BF429, 880, 284},
+    {0x80444B5E7AA7CF85, 907, 292},
+    {0xBF21E44003ACDD2D, 933, 300},
+    {0x8E679C2F5E44FF8F, 960, 308},
+    {0xD433179D9C8CB841, 986, 316},
+    {0x9E19DB92B4E31BA9, 1013, 324},
+};
+
+const int CACHED_POWERS_MIN_EXPONENT = -300;
+const int CACHED_POWERS_STEP = 8;
+
+/*
+ * the product of the boundaries with the cached power
+ * has its binary exponent in [ALPHA, ALPHA + 28]
+ */
+const int ALPHA = -60;
+
+
+const Cached_power&
+cached_power(int e) {
+    auto f = ALPHA - e - 1;
+    auto k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+    auto index = (-CACHED_POWERS_MIN_EXPONENT + k + (CACHED_POWERS_STEP - 1)) / CACHED_POWERS_STEP;
+    return CACHED_POWERS[index];
+}
+
+
+//! number of digits of n, pow10 is 10^(digits - 1)
+int
+largest_pow10(uint32_t n, uint32_t &pow10) {
+    int digits = 10;
+    pow10 = 1000000000;
+    while (pow10 > n && digits > 1) {
+        pow10 /= 10;
+        --digits;
+    }
+    return digits;
+}
+
+
+//! moves the last digit towards the value while it stays in the boundaries
+void
+round_weed(char *digits, int count, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) {
+    while (rest < dist
+            && delta - rest >= ten_k
+            && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+        --digits[count - 1];
+        rest += ten_k;
+    }
+}
+
+
+/*
+ * digits of the value v > 0: v ~ digits * 10^exponent
+ */
+void
+grisu2(double v, char *digits, int &count, int &exponent) {
+    /*
+     * the boundaries m- and m+ are halfway to the neighbours of v
+     */
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    const uint64_t HIDDEN_BIT = uint64_t(1) << 52;
+    auto biased_e = static_cast<int>(bits >> 52);
+    auto fraction = bits & (HIDDEN_BIT - 1);
+
+    Diyfp w = biased_e == 0 ?
+        Diyfp{fraction, 1 - 1075}
+        : Diyfp{fraction + HIDDEN_BIT, biased_e - 1075};
+    auto lower_closer = fraction == 0 && biased_e > 1;
+
+    auto m_plus = normalize(Diyfp{2 * w.f + 1, w.e - 1});
+    auto m_minus = lower_closer ?
+        Diyfp{4 * w.f - 1, w.e - 2} : Diyfp{2 * w.f - 1, w.e - 1};
+    m_minus = Diyfp{m_minus.f << (m_minus.e - m_plus.e), m_plus.e};
+    w = normalize(w);
+
+    const auto &cached = cached_power(m_plus.e);
+    Diyfp c_minus_k{cached.f, cached.e};
+    auto w_scaled = mul(w, c_minus_k);
+    auto lower = mul(m_minus, c_minus_k);
+    auto upper = mul(m_plus, c_minus_k);
+    lower.f += 1;
+    upper.f -= 1;
+    exponent = -cached.k;
+
+    /*
+     * digits of upper until the rest is within the boundaries
+     */
+    auto delta = sub(upper, lower).f;
+    auto dist = sub(upper, w_scaled).f;
+    Diyfp one{uint64_t(1) << -upper.e, upper.e};
+
+    auto p1 = static_cast<uint32_t>(upper.f >> -one.e);
+    auto p2 = upper.f & (one.f - 1);
+
+    count = 0;
+    uint32_t pow10;
+    auto n = largest_pow10(p1, pow10);
+    while (n > 0) {
+        digits[count++] = static_cast<char>('0' + p1 / pow10);
+        p1 %= pow10;
+        --n;
+        auto rest = (uint64_t(p1) << -one.e) + p2;
+        if (rest <= delta) {
+            exponent += n;
+            round_weed(digits, count, dist, delta, rest, uint64_t(pow10) << -one.e);
+            return;
+        }
+        pow10 /= 10;
+    }
+
+    int m = 0;
+    for (;;) {
+        p2 *= 10;
+        digits[count++] = static_cast<char>('0' + (p2 >> -one.e));
+        p2 &= one.f - 1;
+        ++m;
+        delta *= 10;
+        dist *= 10;
+        if (p2 <= delta) break;
+    }
+    exponent -= m;
+    round_weed(digits, count, dist, delta, p2, one.f);
+}
+
+}  // namespace
+
+
+char*
+format_int(int64_t value, char *buffer) {
+    char digits[NUMBER_SIZE];
+    auto end = digits + sizeof(digits);
+    auto p = write_digits(magnitude(value), end);
+    if (value < 0) *--p = '-';
+    return copy(p, end, buffer);
+}
+
+
+char*
+format_fixed(int64_t value, int decimals, char *buffer) {
+    char digits[NUMBER_SIZE];
+    auto end = digits + sizeof(digits);
+    auto p = end;
+    auto rest = magnitude(value);
+    for (int i = 0; i < decimals; ++i, rest /= 10) {
+        *--p = static_cast<char>('0' + rest % 10);
+    }
+    if (decimals > 0) *--p = '.';
+    p = write_digits(rest, p);
+    if (value < 0) *--p = '-';
+    return copy(p, end, buffer);
+}
+
+
+char*
+format_double(double value, char *buffer) {
+    if (std::isnan(value)) return copy("NaN", "NaN" + 3, buffer);
+    if (std::isinf(value)) {
+        return value < 0 ?
+            copy("-Infinity", "-Infinity" + 9, buffer)
+            : copy("Infinity", "Infinity" + 8, buffer);
+    }
+
+    auto p = buffer;
+    if (std::signbit(value)) {
+        *p++ = '-';
+        value = -value;
+    }
+
+    /*
+     * integer values (speeds, priorities, ...)
+     */
+    if (value < 1e15 && value == std::trunc(value)) {
+        return format_int(static_cast<int64_t>(value), p);
+    }
+
+    char digits[NUMBER_SIZE];
+    int count = 0;
+    int exponent = 0;
+    grisu2(value, digits, count, exponent);
+
+    /*
+     * value = digits * 10^exponent
+     * written like %g: fixed unless the number is too large or too small
+     */
+    auto point = count + exponent;
+    if (point - 1 < -4 || point - 1 >= 17) {
+        *p++ = digits[0];
+        if (count > 1) {
+            *p++ = '.';
+            p = copy(digits + 1, digits + count, p);
+        }
+        *p++ = 'e';
+        *p++ = point - 1 < 0 ? '-' : '+';
+        return format_int(std::abs(point - 1), p);
+    }
+    if (exponent >= 0) {
+        p = copy(digits, digits + count, p);
+        for (int i = 0; i < exponent; ++i) *p++ = '0';
+        return p;
+    }
+    if (point > 0) {
+        p = copy(digits, digits + point, p);
+        *p++ = '.';
+        return copy(digits + point, digits + count, p);
+    }
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = point; i < 0; ++i) *p++ = '0';
+    return copy(digits, digits + count, p);
+}
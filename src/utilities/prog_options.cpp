@@ -46,7 +46,7 @@ void get_option_description(po::options_description &od_desc) {
 
     general_od_desc.add_options()
         // general
-        ("file,f", po::value<std::string>()->required(), "REQUIRED: Name of the osm file.")
+        ("file,f", po::value<std::string>()->required(), "REQUIRED: Name of the osm file (.osm, .osm.gz, .osm.bz2 or .osm.pbf).")
         ("conf,c", po::value<std::string>()->default_value("/usr/share/osm2pgrouting/mapconfig.xml"), "Name of the configuration xml file.")
         ("schema", po::value<std::string>()->default_value(""), "Database schema to put tables.\n  blank:\t defaults to default schema dictated by PostgreSQL search_path.")
         ("prefix", po::value<std::string>()->default_value(""), "Prefix added at the beginning of the table names.")
@@ -55,11 +55,24 @@ void get_option_description(po::options_description &od_desc) {
         ("postgis", "Install postgis if not found.")  // TODO(vicky) remove before realesing
 #endif
         ("addnodes", "Import the osm_nodes, osm_ways & osm_relations tables.")
+        ("one-pass", "Read the osm file once, keeping all its nodes and ways in memory.\n  Otherwise (without --addnodes) a first pass finds the routable ways and their nodes: the file is read once more, twice more when relations make ways routable (a compressed file is decompressed 2 or 3 times).")
+        ("rank-index", "Find the nodes of the ways with a rank index instead of a binary search.\n  Uses 1.13 bits per id up to the largest node id.")
+        ("nodes-file", po::value<std::string>(), "Keep the nodes in memory mapped files (arg.ids, arg.lats, ...) instead of the memory.\n  The files are not left on the disk.")
+        ("nodes-layout", po::value<std::string>()->default_value("sparse"), "Layout of the nodes.\n  sparse:\t sorted ids of the nodes.\n  dense:\t indexed by node id (planet size files, requires --nodes-file).")
         ("attributes", "Include attributes information.")
         ("tags", "Include tag information.")
         ("chunk", po::value<std::size_t>()->default_value(20000), "Exporting chunk size.")
+        ("binary-copy", "Copy the ways rows in binary, the geometries in EWKB.")
+        ("connections", po::value<std::size_t>()->default_value(1), "Connections copying the ways chunks concurrently.\n  Each connection copies into its own staging table, the staging tables are merged at the end.")
+        ("read-size", po::value<std::size_t>()->default_value(8), "Size in MB of the blocks given to the XML parser.")
+        ("no-mmap", "Don't memory map the osm file: the XML file is read by a single parser (--threads cuts the slices of a mapped file).")
+        ("threads,t", po::value<std::size_t>()->default_value(1), "Threads used to parse the osm file and to prepare the ways rows.\n  0:\t one per core.\n  1:\t a single parser.")
+        ("bulk-load", "Load profile of a bulk import: synchronous_commit off and a large maintenance_work_mem for the sessions, COPY FREEZE into the tables created or truncated in the COPY transaction (the staging tables and an empty vertices table that no foreign key references; the ways are inserted from the staging tables and are not frozen), ANALYZE and autovacuum enabled again at the end.")
+        ("maintenance-work-mem", po::value<std::string>()->default_value("1GB"), "maintenance_work_mem of the sessions with --bulk-load.")
+        ("unlogged", "Create the tables UNLOGGED, they are SET LOGGED at the end.")
         ("clean", "Drop previously created tables.")
-        ("no-index", "Do not create indexes (Use when indexes are already created)");
+        ("no-index", "Do not create indexes (Use when indexes are already created)")
+        ("index-connections", po::value<std::size_t>()->default_value(4), "Connections building the indexes and the keys concurrently.\n  Each connection uses its own maintenance_work_mem.");
 #if 0
         ("addways", "Import the osm_ways table.")
         ("addrelations", "Import the osm_relations table.")
@@ -76,7 +89,6 @@ void get_option_description(po::options_description &od_desc) {
         ("password,W", po::value<std::string>()->default_value(""), "Password for database access.");
 
     not_used_od_desc.add_options()
-        ("threads,t", po::value<bool>()->default_value(false), "threads.")
         ("multimodal,m", po::value<bool>()->default_value(false), "multimodal.")
         ("multilevel,l", po::value<bool>()->default_value(false), "multilevel.");
 
@@ -106,7 +118,24 @@ process_command_line(po::variables_map &vm) {
 #endif
     std::cout << (vm.count("clean")? "D" : "Don't d") << "rop tables\n";
     std::cout << (vm.count("no-index")? "D" : "Don't c") << "reate indexes\n";
+    std::cout << "index connections = " << vm["index-connections"].as<std::size_t>() << "\n";
     std::cout << (vm.count("addnodes")? "A" : "Don't a") << "dd OSM nodes\n";
+    std::cout << (vm.count("addnodes") || vm.count("one-pass") ? "Keep all" : "Keep the routable") << " nodes\n";
+    std::cout << (vm.count("rank-index")? "F" : "Don't f") << "ind the nodes with a rank index\n";
+    if (vm.count("nodes-file")) {
+        std::cout << "nodes file = " << vm["nodes-file"].as<std::string>() << "\n";
+    }
+    std::cout << "nodes layout = " << vm["nodes-layout"].as<std::string>() << "\n";
+    std::cout << (vm.count("no-mmap")? "Don't m" : "M") << "emory map the osm file\n";
+    std::cout << "read size = " << vm["read-size"].as<std::size_t>() << " MB\n";
+    std::cout << "threads = " << vm["threads"].as<std::size_t>() << "\n";
+    std::cout << (vm.count("binary-copy")? "C" : "Don't c") << "opy the ways in binary\n";
+    std::cout << "connections = " << vm["connections"].as<std::size_t>() << "\n";
+    std::cout << (vm.count("bulk-load")? "U" : "Don't u") << "se the bulk load profile\n";
+    if (vm.count("bulk-load")) {
+        std::cout << "maintenance_work_mem = " << vm["maintenance-work-mem"].as<std::string>() << "\n";
+    }
+    std::cout << (vm.count("unlogged")? "C" : "Don't c") << "reate the tables unlogged\n";
 #if 0
     std::cout << (vm.count("addways")? "A" : "Don't a") << "dd OSM ways\n";
     std::cout << (vm.count("addrelations")? "A" : "Don't a") << "dd OSM relations\n";
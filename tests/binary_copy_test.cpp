@@ -0,0 +1,131 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/*
+ * bytes of a ways row written by Binary_copy_writer:
+ * the PGCOPY header, the field count, the integers & doubles in
+ * network byte order, NULL, and the EWKB of the linestring
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "database/binary_copy_writer.h"
+#include "./check.h"
+
+namespace {
+
+using test::check;
+
+/*
+ * the bytes of @b hex, spaces are skipped
+ */
+std::string
+bytes(const std::string &hex) {
+    std::string result;
+    for (size_t i = 0; i < hex.size(); ++i) {
+        if (hex[i] == ' ') continue;
+        result += static_cast<char>(std::stoi(hex.substr(i++, 2), nullptr, 16));
+    }
+    return result;
+}
+
+
+std::string
+hex(const std::string &data) {
+    std::string result;
+    char byte[4];
+    for (auto c : data) {
+        snprintf(byte, sizeof(byte), "%02x ", static_cast<unsigned char>(c));
+        result += byte;
+    }
+    return result;
+}
+
+
+void
+check_bytes(const std::string &data, const std::string &expected, const std::string &message) {
+    check(data == bytes(expected), message + "\n  got:      " + hex(data)
+            + "\n  expected: " + hex(bytes(expected)));
+}
+
+}  // namespace
+
+
+int
+main() {
+    check_bytes(osm2pgr::Binary_copy_writer::header(),
+            "50 47 43 4f 50 59 0a ff 0d 0a 00"  // PGCOPY\n\377\r\n\0
+            " 00 00 00 00"                       // flags
+            " 00 00 00 00",                      // header extension
+            "header");
+    check_bytes(osm2pgr::Binary_copy_writer::trailer(), "ff ff", "trailer");
+
+    /*
+     * the field types of a ways row: gid & osm_id (bigint), tag_id (integer),
+     * length_m, name, an empty name (NULL), x1, the_geom
+     */
+    osm2pgr::Binary_copy_writer row(8);
+    row.field(int64_t(1));
+    row.field(int64_t(4294967301));
+    row.field(int32_t(-2));
+    row.field(1.5);
+    row.field(std::string("Main"));
+    row.field(std::string());
+    row.coordinate(25000000);
+    row.linestring(2);
+    row.point(10000000, -5000000);
+    row.point(20000000, 0);
+    row.end_linestring();
+    row.end_row();
+
+    check_bytes(row.rows(),
+            "00 08"                                       // fields of the row
+            " 00 00 00 08  00 00 00 00 00 00 00 01"       // int64 1
+            " 00 00 00 08  00 00 00 01 00 00 00 05"       // int64 2^32 + 5
+            " 00 00 00 04  ff ff ff fe"                   // int32 -2
+            " 00 00 00 08  3f f8 00 00 00 00 00 00"       // float8 1.5
+            " 00 00 00 04  4d 61 69 6e"                   // text "Main"
+            " ff ff ff ff"                                // NULL
+            " 00 00 00 08  40 04 00 00 00 00 00 00"       // float8 2.5 degrees
+            " 00 00 00 2d"                                // 45 bytes of EWKB
+            " 01"                                         // little endian
+            " 02 00 00 20"                                // linestring | srid flag
+            " e6 10 00 00"                                // srid 4326
+            " 02 00 00 00"                                // 2 points
+            " 00 00 00 00 00 00 f0 3f  00 00 00 00 00 00 e0 bf"   // 1 -0.5
+            " 00 00 00 00 00 00 00 40  00 00 00 00 00 00 00 00",  // 2 0
+            "ways row");
+
+    /*
+     * the field count starts every row
+     */
+    row.clear();
+    row.field(int32_t(7));
+    row.end_row();
+    row.field(int32_t(8));
+    check_bytes(row.rows(),
+            "00 08 00 00 00 04 00 00 00 07"
+            " 00 08 00 00 00 04 00 00 00 08",
+            "rows");
+
+    return test::report("binary copy");
+}
@@ -0,0 +1,61 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/*
+ * checks of the tests: a failed check is reported and counted,
+ * the test returns report()
+ */
+
+#ifndef TESTS_CHECK_H_
+#define TESTS_CHECK_H_
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void
+check(bool condition, const std::string &message) {
+    if (condition) return;
+    std::cerr << "FAILED: " << message << "\n";
+    ++failures();
+}
+
+//! exit code of the test
+inline int
+report(const std::string &name) {
+    if (failures()) {
+        std::cerr << name << ": " << failures() << " failed checks\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << name << ": OK\n";
+    return EXIT_SUCCESS;
+}
+
+}  // namespace test
+
+#endif  // TESTS_CHECK_H_
@@ -0,0 +1,139 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/*
+ * start of the COPY transactions: the prepare of a staging table is a
+ * string of statements ending with the SELECT AddGeometryColumn, PQexec
+ * returns the result of that SELECT.
+ */
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "utilities/prog_options.h"
+#include "database/table_management.h"
+#include "database/copy_writer.h"
+#include "./check.h"
+#include "./fake_libpq.h"
+
+namespace po = boost::program_options;
+
+namespace {
+
+using test::check;
+
+po::variables_map
+options() {
+    const char *argv[] = {"copy_begin_test", "-f", "x.osm", "-c", "x.xml", "-d", "x"};
+    po::options_description od_desc("Allowed options");
+    get_option_description(od_desc);
+    po::variables_map vm;
+    po::store(po::parse_command_line(7, argv, od_desc), vm);
+    return vm;
+}
+
+
+bool
+contains(const std::vector<std::string> &statements, const std::string &statement) {
+    for (const auto &s : statements) {
+        if (s == statement) return true;
+    }
+    return false;
+}
+
+
+/*
+ * the staging table of the ways has a geometry column
+ */
+void
+staging_table(const osm2pgr::Tables &tables) {
+    fake_libpq::reset();
+    const auto &ways = tables.get_table("ways");
+    auto prepare = ways.tmp_create("staging_ways");
+    check(prepare.find("AddGeometryColumn") != std::string::npos,
+            "the staging table of the ways adds its geometry column");
+
+    try {
+        osm2pgr::Copy_writer::begin(fake_libpq::connection(), prepare,
+                "COPY staging_ways (gid) FROM STDIN");
+    } catch (const std::exception &e) {
+        check(false, std::string("begin failed: ") + e.what());
+    }
+    const auto &statements = fake_libpq::statements();
+    check(statements.size() == 4, "BEGIN, CREATE, SELECT and COPY are run");
+    check(!contains(statements, "ROLLBACK"), "no rollback");
+    check(!statements.empty() && statements.back() == "COPY staging_ways (gid) FROM STDIN",
+            "the COPY is started");
+}
+
+
+/*
+ * without a prepare the COPY follows the BEGIN
+ */
+void
+no_prepare() {
+    fake_libpq::reset();
+    try {
+        osm2pgr::Copy_writer::begin(fake_libpq::connection(), "", "COPY t (a) FROM STDIN");
+    } catch (const std::exception &e) {
+        check(false, std::string("begin failed: ") + e.what());
+    }
+    check(fake_libpq::statements() == std::vector<std::string>{"BEGIN", "COPY t (a) FROM STDIN"},
+            "BEGIN then COPY");
+}
+
+
+/*
+ * a failing statement of the prepare throws & rolls back: the COPY is not run
+ */
+void
+failing_prepare(const osm2pgr::Tables &tables) {
+    fake_libpq::reset();
+    fake_libpq::fail_on("AddGeometryColumn");
+    bool thrown = false;
+    try {
+        osm2pgr::Copy_writer::begin(fake_libpq::connection(),
+                tables.get_table("ways").tmp_create("staging_ways"),
+                "COPY staging_ways (gid) FROM STDIN");
+    } catch (const std::runtime_error &e) {
+        thrown = std::string(e.what()).find("AddGeometryColumn") != std::string::npos;
+    }
+    const auto &statements = fake_libpq::statements();
+    check(thrown, "the failure is thrown with its statement");
+    check(!statements.empty() && statements.back() == "ROLLBACK", "the transaction is rolled back");
+    check(!contains(statements, "COPY staging_ways (gid) FROM STDIN"), "the COPY is not run");
+}
+
+}  // namespace
+
+
+int
+main() {
+    osm2pgr::Tables tables(options());
+
+    staging_table(tables);
+    no_prepare();
+    failing_prepare(tables);
+
+    return test::report("copy begin");
+}
@@ -0,0 +1,151 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+#include "./fake_libpq.h"
+
+#include <cctype>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> g_statements;
+std::string g_copy_data;
+std::string g_fail_on;
+int g_connection;
+
+/*
+ * the results are static: PQclear does nothing
+ */
+ExecStatusType g_results[] = {
+    PGRES_COMMAND_OK, PGRES_TUPLES_OK, PGRES_COPY_IN, PGRES_FATAL_ERROR};
+
+PGresult*
+result(ExecStatusType status) {
+    for (auto &r : g_results) {
+        if (r == status) return reinterpret_cast<PGresult*>(&r);
+    }
+    return nullptr;
+}
+
+
+bool
+starts_with(const std::string &sql, const std::string &word) {
+    return sql.compare(0, word.size(), word) == 0;
+}
+
+
+/*
+ * the statements of @b sql, split on the semicolons out of quotes
+ */
+std::vector<std::string>
+split(const std::string &sql) {
+    std::vector<std::string> statements;
+    std::string statement;
+    bool quoted = false;
+    for (auto c : sql) {
+        if (c == '\'') quoted = !quoted;
+        if (c == ';' && !quoted) {
+            statements.push_back(statement);
+            statement.clear();
+            continue;
+        }
+        statement += c;
+    }
+    statements.push_back(statement);
+
+    std::vector<std::string> trimmed;
+    for (const auto &s : statements) {
+        auto first = s.find_first_not_of(" \t\n");
+        if (first == std::string::npos) continue;
+        trimmed.push_back(s.substr(first, s.find_last_not_of(" \t\n") - first + 1));
+    }
+    return trimmed;
+}
+
+}  // namespace
+
+
+namespace fake_libpq {
+
+PGconn* connection() {return reinterpret_cast<PGconn*>(&g_connection);}
+std::vector<std::string>& statements() {return g_statements;}
+std::string& copy_data() {return g_copy_data;}
+void fail_on(const std::string &pattern) {g_fail_on = pattern;}
+
+void reset() {
+    g_statements.clear();
+    g_copy_data.clear();
+    g_fail_on.clear();
+}
+
+}  // namespace fake_libpq
+
+
+PGresult*
+PQexec(PGconn*, const char *query) {
+    auto status = PGRES_COMMAND_OK;
+    for (const auto &statement : split(query)) {
+        g_statements.push_back(statement);
+        if (!g_fail_on.empty() && statement.find(g_fail_on) != std::string::npos) {
+            return result(PGRES_FATAL_ERROR);
+        }
+        status = starts_with(statement, "SELECT") ? PGRES_TUPLES_OK
+            : starts_with(statement, "COPY") ? PGRES_COPY_IN
+            : PGRES_COMMAND_OK;
+    }
+    return result(status);
+}
+
+ExecStatusType
+PQresultStatus(const PGresult *res) {
+    return res ? *reinterpret_cast<const ExecStatusType*>(res) : PGRES_FATAL_ERROR;
+}
+
+void PQclear(PGresult*) {}
+
+char*
+PQerrorMessage(const PGconn*) {
+    static char message[] = "ERROR: failure of the fake server\n";
+    return message;
+}
+
+char*
+PQresultErrorMessage(const PGresult *res) {
+    return PQerrorMessage(reinterpret_cast<const PGconn*>(res));
+}
+
+int
+PQputCopyData(PGconn*, const char *buffer, int nbytes) {
+    g_copy_data.append(buffer, static_cast<size_t>(nbytes));
+    return 1;
+}
+
+int PQputCopyEnd(PGconn*, const char*) {return 1;}
+
+/*
+ * one result for the COPY, then the end of the results
+ */
+PGresult*
+PQgetResult(PGconn*) {
+    static bool done = false;
+    done = !done;
+    return done ? result(PGRES_COMMAND_OK) : nullptr;
+}
@@ -0,0 +1,60 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/*
+ * libpq replaced for the tests: no server is needed
+ *
+ * PQexec answers as the server does for a string of statements:
+ * they run in order until one fails, the result is the one of
+ * the last statement run:
+ * - a SELECT returns PGRES_TUPLES_OK
+ * - a COPY ... FROM STDIN returns PGRES_COPY_IN
+ * - the other statements return PGRES_COMMAND_OK
+ * - a statement holding the failure pattern returns PGRES_FATAL_ERROR
+ */
+
+#ifndef TESTS_FAKE_LIBPQ_H_
+#define TESTS_FAKE_LIBPQ_H_
+#pragma once
+
+#include <libpq-fe.h>
+#include <string>
+#include <vector>
+
+namespace fake_libpq {
+
+//! a connection to the fake server
+PGconn* connection();
+
+//! the statements run, a string of statements gives one entry per statement
+std::vector<std::string>& statements();
+
+//! the data received by PQputCopyData
+std::string& copy_data();
+
+//! the statements holding @b pattern fail (empty: none fails)
+void fail_on(const std::string &pattern);
+
+//! forgets the statements, the data & the failure pattern
+void reset();
+
+}  // namespace fake_libpq
+
+#endif  // TESTS_FAKE_LIBPQ_H_
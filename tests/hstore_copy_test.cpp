@@ -0,0 +1,131 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/*
+ * round trip of the tags & attributes hstore columns through the COPY rows:
+ * the hstore text of an element is written with Copy_writer, then the
+ * COPY escaping and the hstore quoting are decoded as the server does.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "osm_elements/osm_element.h"
+#include "osm_elements/osm_tag.h"
+#include "database/copy_writer.h"
+#include "./check.h"
+
+namespace {
+
+using test::check;
+
+
+/*
+ * decodes a field of a COPY row in text format
+ */
+std::string
+copy_decode(const std::string &row) {
+    std::string field;
+    for (size_t i = 0; i < row.size(); ++i) {
+        auto c = row[i];
+        if (c == '\n') break;
+        check(c != '\t', "single field expected");
+        if (c != '\\') {
+            field += c;
+            continue;
+        }
+        switch (row[++i]) {
+            case 'n': field += '\n'; break;
+            case 't': field += '\t'; break;
+            case 'r': field += '\r'; break;
+            case '\\': field += '\\'; break;
+            default: check(false, "unexpected COPY escape");
+        }
+    }
+    return field;
+}
+
+
+/*
+ * reads a quoted string of the hstore text at @b i
+ */
+std::string
+hstore_string(const std::string &text, size_t &i) {
+    while (i < text.size() && text[i] == ' ') ++i;
+    check(i < text.size() && text[i] == '"', "quoted hstore string expected");
+    std::string value;
+    for (++i; i < text.size() && text[i] != '"'; ++i) {
+        if (text[i] == '\\') ++i;
+        value += text[i];
+    }
+    ++i;
+    return value;
+}
+
+
+std::map<std::string, std::string>
+hstore_decode(const std::string &text) {
+    std::map<std::string, std::string> values;
+    size_t i = 0;
+    while (i < text.size()) {
+        auto key = hstore_string(text, i);
+        while (i < text.size() && text[i] == ' ') ++i;
+        check(text.compare(i, 2, "=>") == 0, "=> expected after " + key);
+        i += 2;
+        values[key] = hstore_string(text, i);
+        while (i < text.size() && (text[i] == ' ' || text[i] == ',')) ++i;
+    }
+    return values;
+}
+
+
+std::map<std::string, std::string>
+round_trip(const osm2pgr::Element &element, const std::string &column) {
+    osm2pgr::Copy_writer writer;
+    writer.fields(element.values({column}, true));
+    writer.end_row();
+    return hstore_decode(copy_decode(writer.rows()));
+}
+
+}  // namespace
+
+
+int
+main() {
+    const char *atts[] = {"id", "42", "user", "tab\tuser", nullptr};
+    osm2pgr::Element element(atts);
+
+    element.add_tag(osm2pgr::Tag("name", "line 1\nline 2"));
+    element.add_tag(osm2pgr::Tag("note", "a\tb\r\nc"));
+    element.add_tag(osm2pgr::Tag("path", "C:\\osm\\\\data"));
+    element.add_tag(osm2pgr::Tag("ref", "O'Brien, A=>B"));
+
+    auto tags = round_trip(element, "tags");
+    check(tags == element.tags(), "tags round trip");
+    for (const auto &tag : element.tags()) {
+        check(tags[tag.first] == tag.second, "tag " + tag.first);
+    }
+
+    auto attributes = round_trip(element, "attributes");
+    check(attributes == element.attributes(), "attributes round trip");
+
+    return test::report("hstore round trip");
+}
@@ -0,0 +1,133 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/*
+ * decoding of a .osm.pbf file: tests/data/decode_test.osm.pbf holds the
+ * elements of tests/data/decode_test.osm (dense nodes, 3 elements a block),
+ * both files must give the same nodes, ways & relations to the callback.
+ *
+ * usage: pbf_decode_test <directory of decode_test.osm>
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "parser/XMLParser.h"
+#include "parser/PBFParser.h"
+#include "./check.h"
+
+namespace {
+
+using test::check;
+
+struct Element {
+    std::string kind;
+    int64_t id;
+    double lat;
+    double lon;
+    //! "nd <ref>", "member <type> <ref> <role>", "tag <k>=<v>" in order
+    std::vector<std::string> children;
+};
+
+
+/*
+ * records the elements given by a parser
+ */
+class Recorder : public xml::XMLParserCallback {
+ public:
+    void StartElement(const char *name, const char** atts) override {
+        std::string kind(name);
+        if (kind == "node" || kind == "way" || kind == "relation") {
+            Element e{kind, std::strtoll(attribute(atts, "id"), nullptr, 10),
+                std::strtod(attribute(atts, "lat"), nullptr),
+                std::strtod(attribute(atts, "lon"), nullptr), {}};
+            elements.push_back(e);
+            return;
+        }
+        if (elements.empty()) return;
+        auto &children = elements.back().children;
+        if (kind == "nd") {
+            children.push_back("nd " + std::string(attribute(atts, "ref")));
+        } else if (kind == "member") {
+            children.push_back("member " + std::string(attribute(atts, "type"))
+                    + " " + attribute(atts, "ref") + " " + attribute(atts, "role"));
+        } else if (kind == "tag") {
+            children.push_back("tag " + std::string(attribute(atts, "k"))
+                    + "=" + attribute(atts, "v"));
+        }
+    }
+
+    void EndElement(const char*) override {}
+
+    std::vector<Element> elements;
+
+ private:
+    static const char* attribute(const char **atts, const char *name) {
+        for (; *atts; atts += 2) {
+            if (std::strcmp(atts[0], name) == 0) return atts[1];
+        }
+        return "";
+    }
+};
+
+
+void
+compare(const std::vector<Element> &xml, const std::vector<Element> &pbf) {
+    check(xml.size() == 13, "13 elements in the XML file");
+    check(pbf.size() == xml.size(), "as many elements in the PBF file");
+    for (size_t i = 0; i < xml.size() && i < pbf.size(); ++i) {
+        auto name = xml[i].kind + " " + std::to_string(xml[i].id);
+        check(pbf[i].kind == xml[i].kind && pbf[i].id == xml[i].id, name + ": same element");
+        /*
+         * the PBF coordinates are integers of 1e-7 degrees
+         */
+        check(std::fabs(pbf[i].lat - xml[i].lat) < 0.5e-7, name + ": same latitude");
+        check(std::fabs(pbf[i].lon - xml[i].lon) < 0.5e-7, name + ": same longitude");
+        check(pbf[i].children == xml[i].children, name + ": same refs, members & tags");
+    }
+}
+
+}  // namespace
+
+
+int
+main(int argc, char *argv[]) {
+    std::string directory(argc > 1 ? argv[1] : ".");
+    auto xml_file = directory + "/decode_test.osm";
+    auto pbf_file = xml_file + ".pbf";
+
+    Recorder xml;
+    check(xml::XMLParser().Parse(xml, xml_file.c_str()) == 0, "the XML file is parsed");
+
+    check(pbf::PBFParser::is_pbf(pbf_file), "the PBF file is recognized");
+    for (size_t threads : {1, 3}) {
+        Recorder pbf;
+        check(pbf::PBFParser(threads).Parse(pbf, pbf_file.c_str()) == 0,
+                "the PBF file is parsed on " + std::to_string(threads) + " threads");
+        compare(xml.elements, pbf.elements);
+    }
+
+    return test::report("pbf decode");
+}
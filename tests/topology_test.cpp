@@ -0,0 +1,238 @@
+/*PGR-GNU*****************************************************************
+
+ Copyright (c) 2017 pgRouting developers
+ Mail: project@pgrouting.org
+
+ ------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+********************************************************************PGR-GNU*/
+
+
+/*
+ * vertices of the routing graph: numbering of the new vertices,
+ * ids of the vertices already in the database, shared endpoints,
+ * duplicated splits
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "osm_elements/Node.h"
+#include "osm_elements/node_store.h"
+#include "osm_elements/osm_tag.h"
+#include "osm_elements/topology.h"
+#include "osm_elements/Way.h"
+#include "utilities/thread_pool.h"
+#include "./check.h"
+
+namespace {
+
+using osm2pgr::Topology;
+using test::check;
+
+/*
+ * the nodes & the ways of a document: the nodes used by several ways
+ * split the ways, the ways have a configuration tag
+ */
+struct Graph {
+    Graph(const std::vector<int64_t> &node_ids,
+            const std::vector<std::vector<int64_t>> &ways_nodes) {
+        for (auto id : node_ids) {
+            auto osm_id = std::to_string(id);
+            auto coordinate = std::to_string(static_cast<double>(id) / 1000);
+            const char *atts[] = {"id", osm_id.c_str(), "lat", coordinate.c_str(),
+                "lon", coordinate.c_str(), nullptr};
+            nodes.add(osm2pgr::Node(atts));
+        }
+        nodes.end_of_nodes();
+
+        int64_t way_id = 0;
+        for (const auto &way_nodes : ways_nodes) {
+            auto osm_id = std::to_string(++way_id);
+            const char *atts[] = {"id", osm_id.c_str(), nullptr};
+            osm2pgr::Way way(atts);
+            way.tag_config(osm2pgr::Tag("highway", "residential"));
+            for (auto id : way_nodes) {
+                auto position = nodes.find(id);
+                way.add_node_index(position);
+                nodes.incrementUse(position);
+            }
+            ways.push_back(way);
+        }
+    }
+
+    //! the splits of the i-th way
+    std::vector<osm2pgr::Way::Split> splits(size_t i) const {
+        std::vector<osm2pgr::Way::Split> result;
+        ways[i].split_me(nodes, result);
+        return result;
+    }
+
+    //! id of the vertex on the node @b osm_id
+    int64_t id(const Topology &topology, int64_t osm_id) const {
+        return topology.id(nodes.find(osm_id));
+    }
+
+    osm2pgr::Node_store nodes;
+    std::vector<osm2pgr::Way> ways;
+};
+
+
+/*
+ * 10 - 20 - 30 - 40 - 50 - 60
+ * the first way is 50 - 60: the vertices are numbered in node order,
+ * not in way order
+ */
+struct Line : Graph {
+    Line() : Graph({10, 20, 30, 40, 50, 60}, {{50, 60}, {10, 20, 30}, {30, 40, 50}}) {}
+};
+
+
+void
+build(Topology &topology, const Graph &graph) {
+    Thread_pool pool(2);
+    topology.build(graph.ways, graph.nodes, pool);
+}
+
+
+void
+new_vertices() {
+    Line graph;
+    Topology topology;
+    build(topology, graph);
+    topology.number(101);
+
+    check(topology.size() == 4, "4 vertices: the ends of the 3 splits");
+    check(graph.id(topology, 10) == 101, "node 10 is the first vertex: max_id + 1");
+    check(graph.id(topology, 30) == 102, "node 30 is the second vertex");
+    check(graph.id(topology, 50) == 103, "node 50 is the third vertex");
+    check(graph.id(topology, 60) == 104, "node 60 is the fourth vertex");
+    check(graph.id(topology, 20) == 0, "node 20 is not a vertex");
+    for (size_t i = 0; i < topology.size(); ++i) {
+        check(topology.is_new(i), "the vertex " + std::to_string(i) + " is new");
+    }
+}
+
+
+void
+shared_endpoints() {
+    Line graph;
+    Topology topology;
+    build(topology, graph);
+    topology.number(1);
+
+    auto first = graph.splits(1);
+    auto second = graph.splits(2);
+    auto third = graph.splits(0);
+    check(first.size() == 1 && second.size() == 1 && third.size() == 1, "one split a way");
+    if (first.size() != 1 || second.size() != 1 || third.size() != 1) return;
+
+    check(topology.id(graph.ways[1].last_node(first[0]))
+            == topology.id(graph.ways[2].first_node(second[0])),
+            "the target of 10-30 is the source of 30-50");
+    check(topology.id(graph.ways[2].last_node(second[0]))
+            == topology.id(graph.ways[0].first_node(third[0])),
+            "the target of 30-50 is the source of 50-60");
+}
+
+
+/*
+ * incremental import: the vertices in the database keep their ids,
+ * the other ones are numbered after the largest id of the database
+ */
+void
+existing_vertices() {
+    Line graph;
+    Topology topology;
+    build(topology, graph);
+    topology.existing(50, 7, graph.nodes);
+    topology.existing(20, 8, graph.nodes);   // not a vertex of the ways
+    topology.existing(99, 9, graph.nodes);   // not in the document
+    topology.number(10);
+
+    check(topology.size() == 4, "the vertices of the database are not added");
+    check(graph.id(topology, 50) == 7, "node 50 keeps its id");
+    check(graph.id(topology, 10) == 10, "node 10 is numbered from max_id + 1");
+    check(graph.id(topology, 30) == 11, "node 30 is numbered next");
+    check(graph.id(topology, 60) == 12, "node 60 is numbered next, after the existing node 50");
+    for (size_t i = 0; i < topology.size(); ++i) {
+        check(topology.is_new(i) == (topology.vertex_id(i) != 7),
+                "only the vertex " + std::to_string(topology.vertex_id(i)) + " is in the database");
+    }
+}
+
+
+/*
+ * 10 - 20 - 30 three times: 20 splits the ways,
+ * the splits of the second way are duplicates of the first way,
+ * the third way goes the other way: a split of a one way street
+ * is not the split in the other direction
+ */
+void
+duplicated_splits() {
+    Graph graph({10, 20, 30}, {{10, 20, 30}, {10, 20, 30}, {30, 20, 10}});
+    Topology topology;
+    build(topology, graph);
+    topology.number(1);
+
+    check(topology.duplicates() == 2, "the 2 splits of the second way are duplicates");
+    for (size_t i = 0; i < graph.ways.size(); ++i) {
+        auto splits = graph.splits(i);
+        check(splits.size() == 2, "2 splits a way");
+        for (const auto &split : splits) {
+            check(topology.is_duplicate(graph.ways[i], split) == (i == 1),
+                    "way " + std::to_string(i + 1) + ": "
+                    + (i == 1 ? "identical nodes are dropped" : "the split is kept"));
+        }
+    }
+}
+
+
+/*
+ * the splits with the same hash are compared on their nodes
+ */
+void
+hash_collisions() {
+    Graph graph({10, 20, 30, 40}, {{10, 20}, {10, 30}, {10, 20}, {10, 20, 40}});
+    /*
+     * all the ways are a split with the hash 42
+     */
+    std::vector<Topology::Edge> edges;
+    for (const auto &way : graph.ways) {
+        edges.push_back(Topology::Edge{42, &way, 0, way.nodeRefs().size()});
+    }
+
+    Topology topology;
+    topology.find_duplicates(edges);
+
+    check(topology.duplicates() == 1, "only the second 10-20 is a duplicate");
+    check(!topology.is_duplicate(graph.ways[0], {0, 2}), "the first 10-20 is kept");
+    check(!topology.is_duplicate(graph.ways[1], {0, 2}), "10-30, same hash as 10-20, is kept");
+    check(topology.is_duplicate(graph.ways[2], {0, 2}), "the second 10-20 is dropped");
+    check(!topology.is_duplicate(graph.ways[3], {0, 3}), "10-20-40, same hash & first nodes, is kept");
+}
+
+}  // namespace
+
+
+int
+main() {
+    new_vertices();
+    shared_endpoints();
+    existing_vertices();
+    duplicated_splits();
+    hash_collisions();
+
+    return test::report("topology");
+}